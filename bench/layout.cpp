@@ -0,0 +1,65 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include "sdi.h"
+#include "timer.h"
+using namespace sdibench;
+
+// Runs the same SDI query on row and column layouts for a grid of sizes
+// and dimensionalities, on independent and anti-correlated data.
+
+auto run(const generator &source, size_t cardinality, size_t dimensionality, layout layout) -> double {
+  sdi method(cardinality, dimensionality, layout);
+  method.build(source);
+  timer query;
+  query.start();
+  method.query();
+  query.stop();
+  return query.runtime() * 1000;
+}
+
+auto main(int argc, char **argv) -> int {
+  size_t scale = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1;
+  const size_t cardinalities[] = {10000 * scale, 100000 * scale};
+  const size_t dimensionalities[] = {2, 4, 8, 12, 16};
+  std::cout << "# distribution | size | dimensions | row (ms) | column (ms) | winner" << std::endl;
+  for (auto anti : {false, true}) {
+    for (auto &&n : cardinalities) {
+      for (auto &&d : dimensionalities) {
+        generator source(anti ? distribution::anticorrelated : distribution::independent, n + d);
+        auto r = run(source, n, d, layout::row);
+        auto c = run(source, n, d, layout::column);
+        std::cout << "#= " << source.name() << " | " << n << " | " << d << " | ";
+        std::cout << r << " | " << c << " | " << (r <= c ? "row" : "column") << std::endl;
+      }
+    }
+  }
+  return 0;
+}
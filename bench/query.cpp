@@ -0,0 +1,79 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include "sdi.h"
+#include "timer.h"
+using namespace sdibench;
+
+// Speedup of the parallel SDI query over the serial one, for 1 to 32
+// threads on independent, correlated and anti-correlated data. Queries use
+// at most one worker per dimension.
+
+auto run(const generator &source, size_t cardinality, size_t dimensionality, size_t threads,
+         size_t &skyline) -> double {
+  sdi method(cardinality, dimensionality);
+  method.build(source);
+  method.threads(threads);
+  timer query;
+  query.start();
+  method.query();
+  query.stop();
+  skyline = method.statistics().SKY;
+  return query.runtime() * 1000;
+}
+
+auto main(int argc, char **argv) -> int {
+  size_t cardinality = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+  size_t dimensionality = argc > 2 ? strtoul(argv[2], nullptr, 10) : 8;
+  const distribution distributions[] = {
+      distribution::independent, distribution::correlated, distribution::anticorrelated
+  };
+  const size_t threads[] = {1, 2, 4, 8, 16, 32};
+  std::cout << "# distribution | size | dimensions | threads | skyline | query (ms) | speedup" << std::endl;
+  for (auto &&shape : distributions) {
+    generator source(shape, cardinality + dimensionality);
+    double serial = 0;
+    size_t expected = 0;
+    for (auto &&t : threads) {
+      size_t skyline = 0;
+      auto qt = run(source, cardinality, dimensionality, t, skyline);
+      if (t == 1) {
+        serial = qt;
+        expected = skyline;
+      } else if (skyline != expected) {
+        std::cerr << "skyline mismatch on " << source.name() << " with " << t << " threads" << std::endl;
+        return 1;
+      }
+      std::cout << "#= " << source.name() << " | " << cardinality << " | " << dimensionality << " | " << t << " | ";
+      std::cout << skyline << " | " << qt << " | " << serial / qt << std::endl;
+    }
+  }
+  return 0;
+}
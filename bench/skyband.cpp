@@ -0,0 +1,118 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "sdi.h"
+#include "timer.h"
+using namespace sdibench;
+
+// k-skyband and top-k dominating queries against the brute-force count of
+// the dominators and the dominated tuples of every tuple, on independent
+// and anti-correlated data. Results are checked against the counts.
+
+auto dominate(const V *p, const V *q, size_t dimensionality) -> bool {
+  bool better = false;
+  for (size_t d = 0; d < dimensionality; ++d) {
+    if (p[d] > q[d]) {
+      return false;
+    }
+    better = better || p[d] < q[d];
+  }
+  return better;
+}
+
+auto main(int argc, char **argv) -> int {
+  size_t cardinality = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+  size_t dimensionality = argc > 2 ? strtoul(argv[2], nullptr, 10) : 4;
+  std::cout << "# distribution | size | dimensions | k | band | skyband (ms) | top-k (ms) | brute force (ms)" << std::endl;
+  for (auto anti : {false, true}) {
+    generator source(anti ? distribution::anticorrelated : distribution::independent, cardinality + dimensionality);
+    sdi method(cardinality, dimensionality);
+    method.build(source);
+    // The values as stored, quantized or not.
+    auto values = method.data()(0);
+    timer bt;
+    bt.start();
+    std::vector<size_t> dominators(cardinality, 0);
+    std::vector<size_t> scores(cardinality, 0);
+    for (size_t i = 0; i < cardinality; ++i) {
+      for (size_t j = 0; j < cardinality; ++j) {
+        if (dominate(&values[i * dimensionality], &values[j * dimensionality], dimensionality)) {
+          ++scores[i];
+          ++dominators[j];
+        }
+      }
+    }
+    bt.stop();
+    for (size_t k : {1, 10, 100}) {
+      timer st;
+      st.start();
+      method.skyband(k);
+      st.stop();
+      auto band = method.skyline();
+      size_t expected = 0;
+      for (auto &&n : dominators) {
+        expected += n < k;
+      }
+      for (auto &&key : band) {
+        if (dominators[key] >= k) {
+          std::cerr << "tuple " << key << " has " << dominators[key] << " dominators in the " << k << "-skyband";
+          std::cerr << std::endl;
+          return 1;
+        }
+      }
+      if (band.size() != expected) {
+        std::cerr << "skyband mismatch for k = " << k << ": " << band.size() << " instead of " << expected;
+        std::cerr << std::endl;
+        return 1;
+      }
+      timer tt;
+      tt.start();
+      method.dominating(k);
+      tt.stop();
+      std::vector<size_t> best(scores);
+      std::sort(best.begin(), best.end(), std::greater<size_t>());
+      for (size_t i = 0; i < k; ++i) {
+        auto key = method.skyline()[i];
+        if (method.scores()[i] != scores[key] || scores[key] != best[i]) {
+          std::cerr << "top-" << k << " mismatch at " << i << ": tuple " << key << " scores " << method.scores()[i];
+          std::cerr << " instead of " << best[i] << std::endl;
+          return 1;
+        }
+      }
+      std::cout << "#= " << source.name() << " | " << cardinality << " | ";
+      std::cout << dimensionality << " | " << k << " | " << band.size() << " | " << st.runtime() * 1000 << " | ";
+      std::cout << tt.runtime() * 1000 << " | " << bt.runtime() * 1000 << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include "sdi-skycube.h"
+#include "timer.h"
+using namespace sdibench;
+
+// Compares the skycube with one subspace query per subspace on the same
+// index, and checks that both give the same skylines.
+
+auto main(int argc, char **argv) -> int {
+  size_t cardinality = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+  size_t dimensionality = argc > 2 ? strtoul(argv[2], nullptr, 10) : 6;
+  size_t threads = argc > 3 ? strtoul(argv[3], nullptr, 10) : 1;
+  MASK all = (1ULL << dimensionality) - 1;
+  std::cout << "# distribution | size | dimensions | subspaces | skycube (ms) | queries (ms) | speedup" << std::endl;
+  for (auto anti : {false, true}) {
+    generator source(anti ? distribution::anticorrelated : distribution::independent, cardinality + dimensionality);
+    skycube cube(cardinality, dimensionality);
+    cube.threads(threads);
+    cube.build(source);
+    timer ct;
+    ct.start();
+    cube.query();
+    ct.stop();
+    sdi method(cardinality, dimensionality);
+    method.build(source);
+    timer qt;
+    for (MASK m = 1; m <= all; ++m) {
+      qt.start();
+      method.query(m);
+      qt.stop();
+      if (method.skyline().size() != cube.size(m)) {
+        std::cerr << "skyline mismatch in subspace " << m << ": " << cube.size(m) << " instead of ";
+        std::cerr << method.skyline().size() << std::endl;
+        return 1;
+      }
+      for (auto &&k : method.skyline()) {
+        if (!cube.contains(k, m)) {
+          std::cerr << "tuple " << k << " missing in subspace " << m << std::endl;
+          return 1;
+        }
+      }
+    }
+    std::cout << "#= " << source.name() << " | " << cardinality << " | ";
+    std::cout << dimensionality << " | " << all << " | " << ct.runtime() * 1000 << " | " << qt.total() * 1000;
+    std::cout << " | " << qt.total() / ct.runtime() << std::endl;
+  }
+  return 0;
+}
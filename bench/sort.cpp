@@ -0,0 +1,111 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "sdi-db.h"
+#include "sdi-types.h"
+#include "sort.h"
+#include "timer.h"
+
+// Compares msort with rsort on entries filled in key order, the way
+// index::build() fills each dimension before sorting it. Entries keep their
+// value here, whether or not the index is built with WITHOUT_INDEX_VALUE.
+
+struct entry {
+  K key;
+  V value;
+};
+
+auto operator<(const entry &e1, const entry &e2) -> bool {
+  return e1.value < e2.value || (e1.value == e2.value && e1.key < e2.key);
+}
+
+auto fill(std::vector<entry> &a, const char *distribution, size_t seed) -> void {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::normal_distribution<double> normal(0, 0.01);
+  std::string name(distribution);
+  // Values are quantized as a database would.
+  sdibench::db scale(0, 1);
+  for (size_t i = 0; i < a.size(); ++i) {
+    double v = uniform(rng);
+    if (name == "clustered") {
+      v = (rng() % 8) / 8.0 + normal(rng);
+    } else if (name == "tied") {
+      v = (rng() % 16) / 16.0;
+    }
+    a[i] = entry{(K) i, scale.quantize(0, v)};
+  }
+}
+
+auto sorted(const std::vector<entry> &a) -> bool {
+  for (size_t i = 1; i < a.size(); ++i) {
+    if (a[i] < a[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto main(int argc, char **argv) -> int {
+  size_t cardinality = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t rounds = argc > 2 ? strtoul(argv[2], nullptr, 10) : 5;
+  const char *distributions[] = {"uniform", "clustered", "tied"};
+  std::vector<entry> a(cardinality);
+  std::cout << "# distribution | size | msort (ms) | rsort (ms)" << std::endl;
+  for (auto &&distribution : distributions) {
+    timer mt;
+    timer rt;
+    for (size_t r = 0; r < rounds; ++r) {
+      fill(a, distribution, r);
+      mt.start();
+      msort(a.data(), a.size());
+      mt.stop();
+      if (!sorted(a)) {
+        std::cerr << "msort failed on " << distribution << std::endl;
+        return 1;
+      }
+      fill(a, distribution, r);
+      rt.start();
+      rsort(a.data(), a.size(), [](const entry &e) {
+        return radix(e.value);
+      });
+      rt.stop();
+      if (!sorted(a)) {
+        std::cerr << "rsort failed on " << distribution << std::endl;
+        return 1;
+      }
+    }
+    std::cout << "#= " << distribution << " | " << cardinality << " | ";
+    std::cout << mt.total() * 1000 / rounds << " | " << rt.total() * 1000 / rounds << std::endl;
+  }
+  return 0;
+}
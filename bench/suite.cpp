@@ -0,0 +1,86 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "sdi-generator.h"
+#include "sdi.h"
+#include "timer.h"
+using namespace sdibench;
+
+// Sweeps sizes and dimensionalities over the three standard distributions,
+// generated in memory, with one "#=" line per run as printed by sdi-bench:
+// method | size | dimensions | skyline | dominance tests | IO | build (ms)
+// | query (ms) | total (ms). Build times include the generation.
+//
+// Usage: bench-suite [SIZES] [DIMENSIONALITIES] [THREADS] [SEED], lists
+// being comma-separated.
+
+auto list(const char *text) -> std::vector<size_t> {
+  std::vector<size_t> values;
+  for (auto p = text; *p;) {
+    char *end;
+    values.push_back(strtoul(p, &end, 10));
+    p = *end ? end + 1 : end;
+  }
+  return values;
+}
+
+auto main(int argc, char **argv) -> int {
+  auto sizes = list(argc > 1 ? argv[1] : "10000,100000");
+  auto dimensionalities = list(argc > 2 ? argv[2] : "2,4,6,8");
+  size_t threads = argc > 3 ? strtoul(argv[3], nullptr, 10) : 1;
+  unsigned long long seed = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1;
+  std::cout << "# method | size | dimensions | skyline | dominance tests | IO | build (ms) | query (ms) | total (ms)";
+  std::cout << std::endl;
+  for (auto shape : {distribution::independent, distribution::correlated, distribution::anticorrelated}) {
+    generator data(shape, seed);
+    std::cout << "# Distribution: " << data.name() << std::endl;
+    for (auto &&dimensionality : dimensionalities) {
+      for (auto &&cardinality : sizes) {
+        timer build;
+        timer query;
+        sdi method(cardinality, dimensionality);
+        method.threads(threads);
+        build.start();
+        method.build(data);
+        build.stop();
+        query.start();
+        method.query();
+        query.stop();
+        double bt = build.runtime() * 1000;
+        double qt = query.runtime() * 1000;
+        auto &counts = method.statistics();
+        std::cout << "#= SDI | " << cardinality << " | " << dimensionality << " | " << counts.SKY << " | " << counts.DT;
+        std::cout << " | " << counts.IO << " | " << bt << " | " << qt << " | " << bt + qt << std::endl;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "sdi.h"
+#include "timer.h"
+using namespace sdibench;
+
+// Latency of sdi::insert() and sdi::erase() against a full rebuild, on
+// independent and anti-correlated data. The maintained skyline is checked
+// against the skyline of the live tuples queried from scratch.
+
+auto main(int argc, char **argv) -> int {
+  size_t cardinality = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+  size_t dimensionality = argc > 2 ? strtoul(argv[2], nullptr, 10) : 6;
+  size_t updates = argc > 3 ? strtoul(argv[3], nullptr, 10) : 1000;
+  std::cout << "# distribution | size | dimensions | insert (us) | erase (us) | rebuild (ms)" << std::endl;
+  for (auto anti : {false, true}) {
+    // Inserted tuples are the rows of the generator past the first ones.
+    generator source(anti ? distribution::anticorrelated : distribution::independent, cardinality + dimensionality);
+    std::mt19937_64 rng(cardinality + dimensionality);
+    std::vector<K> live;
+    for (size_t i = 0; i < cardinality; ++i) {
+      live.push_back(i);
+    }
+    sdi method(cardinality, dimensionality);
+    method.build(source);
+    method.query();
+    timer insert;
+    timer erase;
+    std::vector<double> row(dimensionality);
+    std::vector<V> stored(dimensionality);
+    for (size_t u = 0; u < updates; ++u) {
+      source.row(cardinality + u, row.data(), dimensionality);
+      for (size_t d = 0; d < dimensionality; ++d) {
+        stored[d] = method.data().quantize(d, row[d]);
+      }
+      insert.start();
+      live.push_back(method.insert(stored.data()));
+      insert.stop();
+      // Erase a skyline tuple every other update, the costly case.
+      auto &skyline = method.skyline();
+      K key = u % 2 && !skyline.empty() ? skyline[rng() % skyline.size()] : live[rng() % live.size()];
+      erase.start();
+      method.erase(key);
+      erase.stop();
+      live.erase(std::find(live.begin(), live.end(), key));
+    }
+    timer rebuild;
+    rebuild.start();
+    sdi fresh(method.data(), live);
+    fresh.build();
+    fresh.query();
+    rebuild.stop();
+    std::vector<K> expected;
+    for (auto &&k : fresh.skyline()) {
+      expected.push_back(live[k]);
+    }
+    std::vector<K> actual(method.skyline());
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    if (actual != expected) {
+      std::cerr << "skyline mismatch: " << actual.size() << " instead of " << expected.size() << std::endl;
+      return 1;
+    }
+    std::cout << "#= " << source.name() << " | " << cardinality << " | ";
+    std::cout << dimensionality << " | " << insert.total() * MILLION / updates << " | ";
+    std::cout << erase.total() * MILLION / updates << " | " << rebuild.runtime() * 1000 << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <unistd.h>
+#include "counters.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+static int fds[PERF_COUNTERS] = {-1, -1, -1, -1, -1, -1};
+static bool any = false;
+
+auto counters::available(size_t counter) -> bool {
+  return counter < PERF_COUNTERS && fds[counter] >= 0;
+}
+
+auto counters::name(size_t counter) -> const char * {
+  static const char *names[PERF_COUNTERS] = {
+      "Cycles", "Instructions", "L1 Misses", "LLC Misses", "dTLB Misses", "Branch Misses"
+  };
+  return counter < PERF_COUNTERS ? names[counter] : nullptr;
+}
+
+/**
+ * Open the counters, once, and return how many are available.
+ */
+auto counters::open() -> size_t {
+#ifdef __linux__
+  if (!any) {
+    const unsigned long long read = PERF_COUNT_HW_CACHE_OP_READ << 8;
+    const unsigned long long miss = PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    const struct {
+      unsigned type;
+      unsigned long long config;
+    } events[PERF_COUNTERS] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | read | miss},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | read | miss},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | read | miss},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+    };
+    for (size_t c = 0; c < PERF_COUNTERS; ++c) {
+      struct perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = events[c].type;
+      attr.config = events[c].config;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fds[c] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      any = any || fds[c] >= 0;
+    }
+  }
+#endif
+  size_t n = 0;
+  for (size_t c = 0; c < PERF_COUNTERS; ++c) {
+    n += available(c);
+  }
+  return n;
+}
+
+auto counters::opened() -> bool {
+  return any;
+}
+
+/**
+ * The values of all counters so far, scaled up when the kernel had to
+ * multiplex them; unavailable counters read zero.
+ */
+void counters::read(double *values) {
+  for (size_t c = 0; c < PERF_COUNTERS; ++c) {
+    unsigned long long v[3] = {0, 0, 0};
+    if (fds[c] < 0 || ::read(fds[c], v, sizeof(v)) != sizeof(v)) {
+      values[c] = 0;
+    } else {
+      values[c] = v[2] ? (double) v[0] * v[1] / v[2] : 0;
+    }
+  }
+}
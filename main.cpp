@@ -26,68 +26,445 @@
  * $Id: main.cpp 567 2019-12-23 19:21:14Z li $
  */
 
+#include <algorithm>
 #include <array>
 #include <fstream>
+#include <string>
+#include <unistd.h>
+#include "counters.h"
+#include "sdi-partition.h"
+#include "sdi-skycube.h"
 #include "sdi.h"
 #include "timer.h"
 using namespace sdibench;
 
-auto run_skyline(const char *name, size_t cardinality, size_t dimensionality, const char *filename) -> bool {
+void report(const char *name, size_t cardinality, size_t dimensionality, const stats &counts, size_t memory, double bt,
+            double qt, double qc) {
+  double tt = bt + qt;
+  std::cout << "# Method: " << name << std::endl;
+  std::cout << "# Size: " << cardinality << std::endl;
+  std::cout << "# Dimensions: " << dimensionality << std::endl;
+  std::cout << "# Skyline: " << counts.SKY << std::endl;
+  std::cout << "# Dominance Test Count: " << counts.DT << std::endl;
+  std::cout << "# Dominance Test Extended Count: " << counts.DTE << std::endl;
+  std::cout << "# Stop Line Count: " << counts.STOP << std::endl;
+  std::cout << "# Tested Tuple Count: " << counts.TT << std::endl;
+  std::cout << "# IO Count: " << counts.IO << std::endl;
+  std::cout << "# Memory: " << memory / MILLION << " MB" << std::endl;
+  std::cout << "# Build Time: " << bt << " ms" << std::endl;
+  std::cout << "# Query Time: " << qt << " ms" << std::endl;
+  std::cout << "# Query CPU Time: " << qc << " ms (main thread)" << std::endl;
+  std::cout << "# Total Time: " << tt << " ms" << std::endl;
+  std::cout << "#= " << name << " | " << cardinality << " | " << dimensionality << " | ";
+  std::cout << counts.SKY << " | " << counts.DT << " | " << counts.IO << " | ";
+  std::cout << bt << " | " << qt << " | " << tt << std::endl;
+  phase::report(std::cout);
+}
+
+/**
+ * Run the query the given number of times on one build and return the
+ * median time in ms, the statistics being those of the last run; cpu is
+ * set to the median CPU time in ms of the calling thread. With more than
+ * one run, the time of each one is reported. Phase times add up over all
+ * runs, as their call counts show.
+ */
+template<class _Q>
+auto measure(size_t runs, _Q query, double &cpu) -> double {
+  std::vector<double> times;
+  std::vector<double> cpus;
+  for (size_t r = 0; r < runs; ++r) {
+    timer t(true);
+    t.start();
+    query();
+    t.stop();
+    times.push_back(t.runtime() * 1000);
+    cpus.push_back(t.cpu() * 1000);
+  }
+  if (runs > 1) {
+    std::cout << "# Runs: " << runs << std::endl;
+    std::cout << "# Run Times:";
+    for (auto &&t : times) {
+      std::cout << " " << t;
+    }
+    std::cout << " ms" << std::endl;
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpu = runs % 2 ? cpus[runs / 2] : (cpus[runs / 2 - 1] + cpus[runs / 2]) / 2;
+  std::sort(times.begin(), times.end());
+  return runs % 2 ? times[runs / 2] : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+}
+
+auto run_skyline(const char *name, size_t cardinality, size_t dimensionality, const char *filename,
+                 const generator *source, const char *snapshot, layout layout, size_t threads, MASK subspace, size_t band, size_t top,
+                 size_t runs, bool emit, bool dense, bool verify) -> bool {
   timer build;
-  timer query;
-  sdi method(cardinality, dimensionality);
+  sdi method(cardinality, dimensionality, layout);
+  method.threads(threads);
+  method.dense(dense);
   std::cerr << "Building... ";
-  if (!filename) {
+  if (source) {
+    std::cerr << "(" << source->name() << ") ";
+    build.start();
+    method.build(*source);
+    build.stop();
+  } else if (!filename) {
+    std::cerr << "(STDIN) ";
+    build.start();
+    method.build(std::cin, snapshot);
+    build.stop();
+    if (!method.saved()) {
+      std::cerr << "- cannot save snapshot. " << snapshot << std::endl;
+    }
+  } else {
+    std::cerr << "(" << filename << ") ";
+    build.start();
+    if (!method.build(filename, snapshot)) {
+      std::cerr << "- cannot open file. " << filename << std::endl;
+      return false;
+    }
+    build.stop();
+    if (!method.saved()) {
+      std::cerr << "- cannot save snapshot. " << snapshot << std::endl;
+    }
+    if (verify && method.partial()) {
+      std::cerr << "- cannot verify a prefix of the dataset. " << filename << std::endl;
+      return false;
+    }
+    if (verify && !method.verify()) {
+      std::cerr << "- checksum mismatch. " << filename << std::endl;
+      return false;
+    }
+  }
+  double bt = build.runtime() * 1000;
+  std::cerr << "done in " << bt << " ms." << std::endl;
+  // Wall times to the first results of the last run, and the results as
+  // they come when emitted.
+  const std::array<size_t, 3> firsts = {1, 10, 100};
+  std::vector<double> first;
+  double start = 0;
+  size_t count = 0;
+  size_t run = 0;
+  method.progress([&](K key) {
+    if (first.size() < firsts.size() && ++count == firsts[first.size()]) {
+      first.push_back((timer::microtime() - start) * 1000);
+    }
+    // Without flushing, which would be timed with the query.
+    if (emit && run == runs) {
+      std::cout << key << '\n';
+    }
+  });
+  std::cerr << "Querying... ";
+  double qc = 0;
+  double qt = measure(runs, [&] {
+    ++run;
+    first.clear();
+    count = 0;
+    start = timer::microtime();
+    if (top) {
+      method.dominating(top);
+    } else if (band) {
+      method.skyband(band);
+    } else if (subspace) {
+      method.query(subspace);
+    } else {
+      method.query();
+    }
+  }, qc);
+  std::cerr << "done in " << qt << " ms." << std::endl;
+  for (size_t i = 0; i < first.size(); ++i) {
+    std::cout << "# First " << firsts[i] << " Time: " << first[i] << " ms" << std::endl;
+  }
+  if (top) {
+    std::cout << "# Top Scores:";
+    for (auto &&s : method.scores()) {
+      std::cout << " " << s;
+    }
+    std::cout << std::endl;
+  }
+  report(name, cardinality, dimensionality, method.statistics(), method.memory(), bt, qt, qc);
+  return true;
+}
+
+auto run_partition(const char *name, size_t cardinality, size_t dimensionality, const char *filename,
+                   const generator *source, layout layout, size_t threads, size_t partitions, size_t runs, bool verify) -> bool {
+  timer build;
+  partition method(cardinality, dimensionality, layout);
+  method.threads(threads);
+  method.partitions(partitions);
+  std::cerr << "Loading... ";
+  if (source) {
+    std::cerr << "(" << source->name() << ") ";
+    build.start();
+    method.build(*source);
+    build.stop();
+  } else if (!filename) {
     std::cerr << "(STDIN) ";
     build.start();
     method.build(std::cin);
     build.stop();
   } else {
     std::cerr << "(" << filename << ") ";
-    std::ifstream fin(filename);
-    if (!fin.good()) {
+    build.start();
+    if (!method.build(filename)) {
       std::cerr << "- cannot open file. " << filename << std::endl;
       return false;
     }
+    build.stop();
+    if (verify && method.partial()) {
+      std::cerr << "- cannot verify a prefix of the dataset. " << filename << std::endl;
+      return false;
+    }
+    if (verify && !method.verify()) {
+      std::cerr << "- checksum mismatch. " << filename << std::endl;
+      return false;
+    }
+  }
+  double bt = build.runtime() * 1000;
+  std::cerr << "done in " << bt << " ms." << std::endl;
+  std::cerr << "Querying " << method.partitions() << " partitions... ";
+  double qc = 0;
+  double qt = measure(runs, [&] {
+    method.query();
+  }, qc);
+  std::cerr << "done in " << qt << " ms, " << method.candidates() << " candidates merged." << std::endl;
+  report(name, cardinality, dimensionality, method.statistics(), method.memory(), bt, qt, qc);
+  return true;
+}
+
+auto run_skycube(const char *name, size_t cardinality, size_t dimensionality, const char *filename,
+                 const generator *source, layout layout, size_t threads, size_t runs, bool verify) -> bool {
+  timer build;
+  skycube method(cardinality, dimensionality, layout);
+  method.threads(threads);
+  std::cerr << "Building... ";
+  if (source) {
+    std::cerr << "(" << source->name() << ") ";
     build.start();
-    method.build(fin);
+    method.build(*source);
+    build.stop();
+  } else if (!filename) {
+    std::cerr << "(STDIN) ";
+    build.start();
+    method.build(std::cin);
+    build.stop();
+  } else {
+    std::cerr << "(" << filename << ") ";
+    build.start();
+    if (!method.build(filename)) {
+      std::cerr << "- cannot open file. " << filename << std::endl;
+      return false;
+    }
     build.stop();
+    if (verify && method.partial()) {
+      std::cerr << "- cannot verify a prefix of the dataset. " << filename << std::endl;
+      return false;
+    }
+    if (verify && !method.verify()) {
+      std::cerr << "- checksum mismatch. " << filename << std::endl;
+      return false;
+    }
   }
   double bt = build.runtime() * 1000;
   std::cerr << "done in " << bt << " ms." << std::endl;
-  std::cerr << "Querying... ";
-  query.start();
-  method.query();
-  query.stop();
-  double qt = query.runtime() * 1000;
+  std::cerr << "Querying " << (1ULL << dimensionality) - 1 << " subspaces... ";
+  double qc = 0;
+  double qt = measure(runs, [&] {
+    method.query();
+  }, qc);
   std::cerr << "done in " << qt << " ms." << std::endl;
-  double tt = bt + qt;
-  std::cout << "# Method: " << name << std::endl;
-  std::cout << "# Size: " << cardinality << std::endl;
-  std::cout << "# Dimensions: " << dimensionality << std::endl;
-  std::cout << "# Skyline: " << db::SKY << std::endl;
-  std::cout << "# Dominance Test Count: " << db::DT << std::endl;
-  std::cout << "# Dominance Test Extended Count: " << db::DTE << std::endl;
-  std::cout << "# Stop Line Count: " << db::STOP << std::endl;
-  std::cout << "# Tested Tuple Count: " << db::TT << std::endl;
-  std::cout << "# IO Count: " << db::IO << std::endl;
-  std::cout << "# Build Time: " << bt << " ms" << std::endl;
-  std::cout << "# Query Time: " << qt << " ms" << std::endl;
-  std::cout << "# Total Time: " << tt << " ms" << std::endl;
-  std::cout << "#= " << name << " | " << cardinality << " | " << dimensionality << " | ";
-  std::cout << db::SKY << " | " << db::DT << " | " << db::IO << " | ";
-  std::cout << bt << " | " << qt << " | " << tt << std::endl;
+  size_t total = 0;
+  for (MASK m = 1; m < 1ULL << dimensionality; ++m) {
+    total += method.size(m);
+  }
+  std::cout << "# Subspaces: " << (1ULL << dimensionality) - 1 << std::endl;
+  std::cout << "# Subspace Skyline Total: " << total << std::endl;
+  std::cout << "# Skycube Tuples: " << method.tuples().size() << std::endl;
+  report(name, cardinality, dimensionality, method.statistics(), method.memory(), bt, qt, qc);
+  return true;
+}
+
+auto run_convert(size_t cardinality, size_t dimensionality, const char *filename, const generator *source,
+                 const char *output, layout layout, size_t threads) -> bool {
+  timer convert;
+  db data(cardinality, dimensionality, layout);
+  std::cerr << "Converting... ";
+  convert.start();
+  if (source) {
+    std::cerr << "(" << source->name() << ") ";
+    source->generate(data, threads);
+  } else if (!filename) {
+    std::cerr << "(STDIN) ";
+    std::cin >> data;
+  } else {
+    std::cerr << "(" << filename << ") ";
+    if (!data.load(filename, threads)) {
+      std::cerr << "- cannot open file. " << filename << std::endl;
+      return false;
+    }
+  }
+  if (!data.save(output, layout)) {
+    std::cerr << "- cannot write file. " << output << std::endl;
+    return false;
+  }
+  convert.stop();
+  std::cerr << "done in " << convert.runtime() * 1000 << " ms." << std::endl;
   return true;
 }
 
 auto main(int argc, char **argv) -> int {
-  if (argc < 3) {
-    std::cout << "Usage: bench-sdi [FILE] DIMENSIONALITY CARDINALITY" << std::endl;
+  size_t threads = 1;
+  const char *output = nullptr;
+  const char *snapshot = nullptr;
+  layout layout = layout::row;
+  bool cube = false;
+  bool partitioned = false;
+  MASK subspace = 0;
+  size_t partitions = 0;
+  size_t band = 0;
+  size_t top = 0;
+  size_t runs = 1;
+  bool emit = false;
+  bool dense = false;
+  const char *synthetic = nullptr;
+  bool verify = false;
+  bool profile = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "ab:cdeg:i:k:l:o:p:r:s:t:x")) != -1) {
+    switch (opt) {
+    case 'a':
+      cube = true;
+      break;
+    case 'b':
+      band = strtoul(optarg, nullptr, 10);
+      break;
+    case 'c':
+      verify = true;
+      break;
+    case 'd':
+      dense = true;
+      break;
+    case 'e':
+      emit = true;
+      break;
+    case 'g':
+      synthetic = optarg;
+      break;
+    case 'i':
+      snapshot = optarg;
+      break;
+    case 'k':
+      top = strtoul(optarg, nullptr, 10);
+      break;
+    case 'l':
+      layout = std::string(optarg) == "column" ? layout::column : layout::row;
+      break;
+    case 'o':
+      output = optarg;
+      break;
+    case 'p':
+      partitioned = true;
+      partitions = strtoul(optarg, nullptr, 10);
+      break;
+    case 'r':
+      runs = strtoul(optarg, nullptr, 10);
+      runs = runs > 0 ? runs : 1;
+      break;
+    case 's':
+      // Dimensions of the subspace, as a comma-separated list, checked
+      // against the dimensionality once it is known.
+      for (auto p = optarg; *p;) {
+        char *end;
+        auto dimension = strtoul(p, &end, 10);
+        if (end == p || dimension >= 64) {
+          std::cerr << "Invalid subspace dimension " << p << "." << std::endl;
+          return 1;
+        }
+        subspace |= 1ULL << dimension;
+        p = *end ? end + 1 : end;
+      }
+      break;
+    case 't':
+      threads = strtoul(optarg, nullptr, 10);
+      break;
+    case 'x':
+      profile = true;
+      break;
+    default:
+      argc = 0;
+    }
+  }
+  argc -= optind;
+  argv += optind;
+  if (argc < 2) {
+    std::cout << "Usage: bench-sdi [-a] [-b K] [-c] [-d] [-e] [-g DISTRIBUTION[:SEED]] [-i INDEX] [-k K] [-l row|column] [-p PARTITIONS] [-r RUNS] [-s DIMENSIONS] [-t THREADS] [-x] [-o OUTPUT] [FILE] DIMENSIONALITY CARDINALITY"
+              << std::endl;
     return 0;
   }
-  const char *filename = argc > 3 ? argv[1] : nullptr;
-  size_t dimensionality = argc > 3 ? strtoul(argv[2], nullptr, 10): strtoul(argv[1], nullptr, 10);
-  size_t cardinality = argc > 3 ? strtoul(argv[3], nullptr, 10) : strtoul(argv[2], nullptr, 10);
-  run_skyline("SDI", cardinality, dimensionality, filename);
+  const char *filename = argc > 2 ? argv[0] : nullptr;
+  size_t dimensionality = argc > 2 ? strtoul(argv[1], nullptr, 10): strtoul(argv[0], nullptr, 10);
+  size_t cardinality = argc > 2 ? strtoul(argv[2], nullptr, 10) : strtoul(argv[1], nullptr, 10);
+  if (dimensionality < 64 && subspace >> dimensionality) {
+    std::cerr << "Subspace dimensions must be below the dimensionality, " << dimensionality << "." << std::endl;
+    return 1;
+  }
+  // A synthetic dataset replaces the file, its seed follows the name.
+  auto shape = distribution::independent;
+  unsigned long long seed = 1;
+  if (synthetic) {
+    std::string spec(synthetic);
+    auto colon = spec.find(':');
+    if (colon != std::string::npos) {
+      seed = strtoull(spec.c_str() + colon + 1, nullptr, 10);
+      spec.resize(colon);
+    }
+    if (!generator::parse(spec.c_str(), shape)) {
+      std::cerr << "Unknown distribution " << spec << ", use independent, correlated or anti-correlated." << std::endl;
+      return 1;
+    }
+  }
+  // Hardware counters are opened before any worker thread is started, so
+  // that all of them are counted.
+  if (profile && !counters::open()) {
+    std::cerr << "Hardware counters are not available, check perf_event_paranoid." << std::endl;
+  }
+  generator data(shape, seed);
+  auto source = synthetic ? &data : nullptr;
+  if (output) {
+    return run_convert(cardinality, dimensionality, filename, source, output, layout, threads) ? 0 : 1;
+  }
+  if (!index::fits(cardinality, dimensionality)) {
+    std::cerr << "Too many tuples for the index, rebuild without WITH_COMPACT_INDEX." << std::endl;
+    return 1;
+  }
+  if (emit && (cube || partitioned)) {
+    std::cerr << "Only the skyline query emits its results, -e cannot be used with -a or -p." << std::endl;
+    return 1;
+  }
+  if (snapshot && (cube || partitioned)) {
+    std::cerr << "Only the skyline query uses an index snapshot, -i cannot be used with -a or -p." << std::endl;
+    return 1;
+  }
+  if (cube) {
+    if (dimensionality > SDI_SKYCUBE_MAX) {
+      std::cerr << "Too many dimensions for a skycube, at most " << SDI_SKYCUBE_MAX << "." << std::endl;
+      return 1;
+    }
+    run_skycube("SDI-CUBE", cardinality, dimensionality, filename, source, layout, threads, runs, verify);
+    return 0;
+  }
+  if (partitioned) {
+    run_partition("SDI-P", cardinality, dimensionality, filename, source, layout, threads, partitions, runs,
+                  verify);
+    return 0;
+  }
+  // Threads still build the index of a skyband or top-k query, which then
+  // runs serially.
+  if ((band || top) && subspace) {
+    std::cerr << "Skybands and top-k queries are on the whole space, -s cannot be used with -b or -k." << std::endl;
+    return 1;
+  }
+  const char *name = top ? "SDI-TOPK" : band ? "SDI-BAND" : "SDI";
+  run_skyline(name, cardinality, dimensionality, filename, source, snapshot, layout, threads, subspace, band, top,
+              runs, emit, dense, verify);
   return 0;
 }
@@ -0,0 +1,80 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+template<class _F>
+void parallel(size_t, _F);
+template<class _F>
+void parallel(size_t, size_t, _F);
+
+/**
+ * Run f(t) for each worker t in [0, threads). The calling thread runs the
+ * worker 0 so that a single thread never spawns anything.
+ */
+template<class _F>
+void parallel(size_t threads, _F f) {
+  if (threads < 2) {
+    f(0);
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t) {
+    workers.emplace_back(f, t);
+  }
+  f(0);
+  for (auto &&w : workers) {
+    w.join();
+  }
+}
+
+/**
+ * Split [0, length) into at most threads contiguous ranges and run
+ * f(first, last) on each of them.
+ */
+template<class _F>
+void parallel(size_t threads, size_t length, _F f) {
+  if (threads > length) {
+    threads = length ? length : 1;
+  }
+  size_t step = length / threads;
+  size_t rest = length % threads;
+  parallel(threads, [&](size_t t) {
+    size_t first = t * step + (t < rest ? t : rest);
+    size_t last = first + step + (t < rest ? 1 : 0);
+    f(first, last);
+  });
+}
+
+#endif //PARALLEL_H
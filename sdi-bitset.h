@@ -0,0 +1,117 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef SDI_BITSET_H
+#define SDI_BITSET_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace sdibench {
+
+/**
+ * A dense set of flags, one bit per row. Words are atomic so that threads
+ * may share a bitset; single-threaded updates use relaxed loads and stores
+ * that compile to plain memory accesses, concurrent ones use set().
+ */
+class bitset {
+public:
+  bitset() = default;
+  explicit bitset(size_t);
+  virtual ~bitset();
+  void clear();
+  void resize(size_t);
+  auto set(size_t) -> bool;
+  auto size() const -> size_t;
+  auto operator[](size_t) const -> bool;
+  void operator()(size_t, bool);
+private:
+  typedef unsigned long long word;
+  static const size_t BITS = sizeof(word) * 8;
+  std::atomic<word> *words_ = nullptr;
+  size_t size_ = 0;
+};
+
+inline bitset::bitset(size_t size) : size_(size) {
+  words_ = new std::atomic<word>[(size_ + BITS - 1) / BITS];
+  clear();
+}
+
+inline bitset::~bitset() {
+  delete[] words_;
+}
+
+inline void bitset::clear() {
+  for (size_t i = 0; i < (size_ + BITS - 1) / BITS; ++i) {
+    words_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * Resize to n flags, keeping the first ones; new flags are cleared.
+ */
+inline void bitset::resize(size_t n) {
+  auto words = new std::atomic<word>[(n + BITS - 1) / BITS];
+  for (size_t i = 0; i < (n + BITS - 1) / BITS; ++i) {
+    words[i].store(i < (size_ + BITS - 1) / BITS ? words_[i].load(std::memory_order_relaxed) : 0,
+                   std::memory_order_relaxed);
+  }
+  if (n < size_ && n % BITS) {
+    words[n / BITS].fetch_and(((word) 1 << (n % BITS)) - 1, std::memory_order_relaxed);
+  }
+  delete[] words_;
+  words_ = words;
+  size_ = n;
+}
+
+/**
+ * Atomically set the flag n, returns whether it was already set.
+ */
+inline auto bitset::set(size_t n) -> bool {
+  auto mask = (word) 1 << (n % BITS);
+  return (words_[n / BITS].fetch_or(mask, std::memory_order_relaxed) & mask) != 0;
+}
+
+inline auto bitset::size() const -> size_t {
+  return size_;
+}
+
+inline auto bitset::operator[](size_t n) const -> bool {
+  return (words_[n / BITS].load(std::memory_order_relaxed) >> (n % BITS)) & 1;
+}
+
+inline void bitset::operator()(size_t n, bool flag) {
+  auto &w = words_[n / BITS];
+  auto mask = (word) 1 << (n % BITS);
+  auto x = w.load(std::memory_order_relaxed);
+  w.store(flag ? x | mask : x & ~mask, std::memory_order_relaxed);
+}
+
+}
+
+#endif //SDI_BITSET_H
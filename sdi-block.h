@@ -32,6 +32,7 @@
 #define SDI_DB_BUFFER 4096
 #define SDI_DB_PRECISION 8
 
+#include <cstring>
 #include <iostream>
 #include "sdi-types.h"
 
@@ -41,6 +42,7 @@ template<class _T>
 class block {
 public:
   explicit block(size_t, size_t);
+  explicit block(size_t, size_t, _T *);
   virtual ~block();
   auto height() const -> size_t;
   auto width() const -> size_t;
@@ -52,19 +54,25 @@ public:
   auto operator[](size_t) const -> _T &;
 private:
   _T *block_ = nullptr;
+  bool owned_ = true;
   size_t height_ = 0;
   size_t width_ = 0;
 };
 
 template<class _T>
 block<_T>::block(size_t height, size_t width) : height_(height), width_(width) {
-  block_ = new _T[height_ * width_];
-  memset(block_, 0, sizeof(_T) * height_ * width_);
+  block_ = new _T[height_ * width_]();
+}
+
+template<class _T>
+block<_T>::block(size_t height, size_t width, _T *data) : block_(data), owned_(false), height_(height), width_(width) {
 }
 
 template<class _T>
 block<_T>::~block() {
-  delete[] block_;
+  if (owned_) {
+    delete[] block_;
+  }
 }
 
 template<class _T>
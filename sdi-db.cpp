@@ -26,176 +26,977 @@
  * $Id: sdi-db.cpp 567 2019-12-23 19:21:14Z li $
  */
 
-#include <array>
+#include <cassert>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <fstream>
 #include <iomanip>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "parallel.h"
 #include "sdi-db.h"
 
-#define FLAGS 5
-#define TEST 0
-#define SKYLINE 1
-#define SKIP 2
-#define MIN 3
-#define SUM 4
+#define BOUNDS 2
+#define MIN 0
+#define SUM 1
+
+#define SDI_DB_STREAM (1 << 20)
+#define SDI_DB_MAGIC "SDIBENCH"
+#define SDI_DB_VERSION 1
+#define SDI_DB_ALIGN 8
+
+// Quantized values take 16 bits, a dimension being scaled from the range of
+// its values, or the one given to scale(), to [0, SDI_DB_STEPS]. Values are
+// then staged as doubles until the range of each dimension is known.
+#define SDI_DB_STEPS 65535
+#ifdef WITH_QUANTIZED
+#define SDI_DB_KIND 'q'
+#define SDI_DB_STAGED true
+#else
+#define SDI_DB_KIND 'f'
+#define SDI_DB_STAGED false
+#endif
 
 namespace sdibench {
 
-size_t db::DT = 0;
-size_t db::DTE = 0;
-size_t db::IO = 0;
-size_t db::SKY = 0;
-size_t db::STOP = 0;
-size_t db::TT = 0;
+/**
+ * Header of a binary dataset, followed by the values either row by row or
+ * column by column, each column holding stride values.
+ */
+struct header {
+  char magic[8];
+  unsigned int version;
+  unsigned int layout;
+  unsigned int kind;
+  unsigned int size;
+  unsigned long long cardinality;
+  unsigned long long dimensionality;
+  unsigned long long stride;
+  unsigned long long checksum;
+  unsigned long long reserved;
+};
+
+static auto delimiter(char c) -> bool {
+  return c == ' ' || c == ',' || c == '\t' || c == '\r';
+}
+
+static auto blank(const char *first, const char *last) -> bool {
+  while (first < last && delimiter(*first)) {
+    ++first;
+  }
+  return first == last;
+}
+
+/**
+ * Parse a decimal number in [first, last) without looking at the locale.
+ * Values with at most 15 significant digits and a small exponent are
+ * computed exactly as strtod would round them; other values fall back to
+ * strtod. The position after the number is returned in next.
+ */
+static auto number(const char *first, const char *last, const char **next) -> double {
+  static const double powers[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  auto p = first;
+  bool negative = false;
+  if (p < last && (*p == '-' || *p == '+')) {
+    negative = *p++ == '-';
+  }
+  unsigned long long mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  auto start = p;
+  while (p < last && *p >= '0' && *p <= '9') {
+    if (digits < 19) {
+      mantissa = mantissa * DEC + (*p - '0');
+      if (mantissa) {
+        ++digits;
+      }
+    } else {
+      ++exponent;
+    }
+    ++p;
+  }
+  if (p < last && *p == '.') {
+    ++p;
+    while (p < last && *p >= '0' && *p <= '9') {
+      if (digits < 19) {
+        mantissa = mantissa * DEC + (*p - '0');
+        if (mantissa) {
+          ++digits;
+        }
+        --exponent;
+      }
+      ++p;
+    }
+  }
+  bool valid = p > start && !(p == start + 1 && *start == '.');
+  if (valid && p < last && (*p == 'e' || *p == 'E')) {
+    auto q = p + 1;
+    bool minus = false;
+    if (q < last && (*q == '-' || *q == '+')) {
+      minus = *q++ == '-';
+    }
+    if (q < last && *q >= '0' && *q <= '9') {
+      int e = 0;
+      while (q < last && *q >= '0' && *q <= '9') {
+        if (e < 10000) {
+          e = e * DEC + (*q - '0');
+        }
+        ++q;
+      }
+      exponent += minus ? -e : e;
+      p = q;
+    }
+  }
+  if (valid && digits <= 15 && exponent >= -22 && exponent <= 22) {
+    *next = p;
+    double value = exponent < 0 ? mantissa / powers[-exponent] : mantissa * powers[exponent];
+    return negative ? -value : value;
+  }
+  // Slow path: long mantissas, large exponents, inf, nan and garbage.
+  auto end = first;
+  while (end < last && !delimiter(*end) && *end != '\n') {
+    ++end;
+  }
+  std::string text(first, end);
+  char *stop = nullptr;
+  double value = strtod(text.c_str(), &stop);
+  *next = stop == text.c_str() ? end : first + (stop - text.c_str());
+  return value;
+}
 
 auto operator>>(std::istream &in, db &db) -> std::istream & {
-  auto delim = " ,";
-  std::array<char, 4096> line{};
-  auto data = line.data();
+  // Read blocks of text and parse the complete lines of each block; an
+  // incomplete last line is carried over to the next block.
+  std::vector<char> buffer(SDI_DB_STREAM);
+  std::vector<double> staged(SDI_DB_STAGED ? db.height_ * db.width_ : 0);
+  std::vector<double> values(db.width_);
+  size_t first = db.size();
+  size_t kept = 0;
   while (in.good()) {
-    in.getline(data, 4096);
-    char *ptr = strtok(data, delim);
-    size_t n = 0;
-    V min = 1;
-    V sum = 0;
-    V value = 0;
-    if (ptr != nullptr) {
-      while (n++ < db.width_) {
-        value = strtod(ptr, nullptr);
-        if (value < min) {
-          min = value;
+    if (kept == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+    in.read(buffer.data() + kept, buffer.size() - kept);
+    auto end = buffer.data() + kept + in.gcount();
+    auto p = (const char *) buffer.data();
+    for (;;) {
+      auto eol = (const char *) memchr(p, '\n', end - p);
+      if (!eol) {
+        if (!in.good()) {
+          eol = end;
+        } else {
+          break;
+        }
+      }
+      if (db.size() < db.height_ && !blank(p, eol)) {
+        auto row = db.size();
+        auto v = SDI_DB_STAGED ? &staged[row * db.width_] : values.data();
+        db.parse_(p, eol, v);
+        if (!SDI_DB_STAGED) {
+          db.store_(row, v);
         }
-        sum += value;
-        db.put_(value);
-        ptr = strtok(nullptr, delim);
+        db.length_ += db.width_;
+      }
+      if (eol == end) {
+        p = end;
+        break;
       }
-      db.put_(0); // Testing flag.
-      db.put_(0); // Skyline flag.
-      db.put_(0); // Skip flag.
-      db.put_(min); // Min value.
-      db.put_(sum); // Sum value.
-      min = 1;
-      sum = 0;
+      p = eol + 1;
     }
+    kept = end - p;
+    memmove(buffer.data(), p, kept);
+  }
+  if (SDI_DB_STAGED) {
+    db.quantize_(staged, first, db.size(), 1);
   }
   return in;
 }
 
 auto operator<<(std::ostream &out, const db &db) -> std::ostream & {
-  size_t n = 0;
-  while (n < db.length_) {
+  for (size_t n = 0; n < db.size(); ++n) {
     out << std::setprecision(8);
-    out << db[n++];
+    out << db.value(n, 0);
     for (size_t i = 1; i < db.width_; ++i) {
-      out << " " << db[n++];
-    }
-    for (size_t i = 0; i < FLAGS; ++i) {
-      n++; // Skip flags.
+      out << " " << db.value(n, i);
     }
     out << std::endl;
   }
   return out;
 }
 
-db::db(size_t height, size_t width) : height_(height), width_(width) {
-  data_ = new V[height_ * (width_ + FLAGS)];
+db::db(size_t height, size_t width) : db(height, width, layout::row) {
+}
+
+db::db(size_t height, size_t width, layout l) : capacity_(height), height_(height), width_(width),
+                                               origin_(width, 0), scale_(width, SDI_DB_STEPS),
+                                               scaled_(width, false), layout_(l),
+                                               erase_(height), skip_(height), skyline_(height), test_(height) {
+  if (layout_ == layout::row) {
+    pitch_ = width_;
+    stride_ = 1;
+  } else {
+    // Columns are padded so that each of them starts on a cache line.
+    pitch_ = 1;
+    stride_ = (height_ + SDI_DB_ALIGN - 1) / SDI_DB_ALIGN * SDI_DB_ALIGN;
+  }
+  void *data = nullptr;
+  size_t values = (layout_ == layout::row ? height_ : stride_) * width_;
+  if (posix_memalign(&data, SDI_DB_ALIGN * sizeof(V), values * sizeof(V))) {
+    throw std::bad_alloc();
+  }
+  data_ = (V *) data;
+  bounds_ = new B[height_ * BOUNDS];
+  // Rows of a common width are tested by kernels of that fixed width.
+  dominate_ = kernel_select(width_);
+  scan_ = layout_ == layout::row ? scan_select(width_) : scan_select();
+}
+
+/**
+ * A view on the rows [first, last) of the database source: values and
+ * bounds are shared with source, which must outlive the view, and flags
+ * are the view's own.
+ */
+db::db(db &source, size_t first, size_t last) : dominate_(source.dominate_), scan_(source.scan_), owned_(false),
+                                                capacity_(last - first), height_(last - first),
+                                                width_(source.width_), origin_(source.origin_),
+                                                scale_(source.scale_), scaled_(source.scaled_),
+                                                layout_(source.layout_),
+                                                pitch_(source.pitch_), stride_(source.stride_),
+                                                erase_(last - first), skip_(last - first),
+                                                skyline_(last - first), test_(last - first) {
+  data_ = source.data_ + first * pitch_;
+  bounds_ = source.bounds_ + first * BOUNDS;
+  length_ = height_ * width_;
+}
+
+/**
+ * A copy of the given rows of the database source, in the given order.
+ */
+db::db(const db &source, const std::vector<K> &rows) : db(rows.size(), source.width_, source.layout_) {
+  origin_ = source.origin_;
+  scale_ = source.scale_;
+  scaled_ = source.scaled_;
+  for (size_t i = 0; i < height_; ++i) {
+    for (size_t d = 0; d < width_; ++d) {
+      data_[i * pitch_ + d * stride_] = source.data_[rows[i] * source.pitch_ + d * source.stride_];
+    }
+    for (size_t b = 0; b < BOUNDS; ++b) {
+      bounds_[i * BOUNDS + b] = source.bounds_[rows[i] * BOUNDS + b];
+    }
+  }
+  length_ = height_ * width_;
 }
 
 db::~db() {
-  delete[] data_;
+  if (!owned_) {
+    return;
+  }
+  if (map_) {
+    munmap(map_, mapped_);
+  } else {
+    free(data_);
+  }
+  delete[] bounds_;
 }
 
-auto db::dominate(V *p1, V *p2) -> bool {
-  ++DTE;
-  if (incomparable(p1, p2)) {
-    return false;
+/**
+ * Append a row of width() values, returns its key. Storage grows by
+ * doubling; mapped values and views are copied to owned storage first.
+ */
+auto db::append(const V *values) -> K {
+  if (height_ == capacity_ || !owned_ || map_) {
+    grow_(height_ == capacity_ ? (capacity_ < 8 ? 16 : capacity_ * 2) : capacity_);
   }
-  ++DT;
-  bool dominating = false;
-  for (size_t i = 0; i < width_; ++i, ++p1, ++p2) {
-    if (*p1 > *p2) {
-      return false;
-    } else if (*p1 < *p2 && !dominating) {
-      dominating = true;
+  size_t row = height_++;
+  for (size_t d = 0; d < width_; ++d) {
+    data_[row * pitch_ + d * stride_] = values[d];
+  }
+  summary_(row);
+  length_ += width_;
+  checksum_ = 0;
+  // The new row has no rank until the index ranks the rows again.
+  ranks_ = nullptr;
+  return (K) row;
+}
+
+/**
+ * Mark a row as skyline from any thread, returns true for the first caller.
+ */
+auto db::claim(size_t row) -> bool {
+  return !skyline_.set(row);
+}
+
+auto db::checksum() const -> unsigned long long {
+  // FNV-1a over the values taken as 64-bit words, in row order whatever
+  // the layout.
+  unsigned long long h = 14695981039346656037ULL;
+  for (size_t i = 0; i < size(); ++i) {
+    for (size_t d = 0; d < width_; ++d) {
+      unsigned long long w = 0;
+      memcpy(&w, &data_[i * pitch_ + d * stride_], sizeof(V));
+      h = (h ^ w) * 1099511628211ULL;
     }
   }
-  return dominating;
+  return h;
+}
+
+auto db::dominate(V *p1, V *p2) -> bool {
+  return dominate((p1 - data_) / pitch_, (p2 - data_) / pitch_);
 }
 
 auto db::dominate(V *p1, size_t row2) -> bool {
-  return dominate(p1, &data_[row2 * (width_ + FLAGS)]);
+  return dominate((p1 - data_) / pitch_, row2);
 }
 
 auto db::dominate(size_t row1, size_t row2) -> bool {
-  return dominate(&data_[row1 * (width_ + FLAGS)], &data_[row2 * (width_ + FLAGS)]);
+  if (mask_) {
+    return masked_(row1, row2);
+  }
+  SDI_COUNT(DTE, 1);
+  if (incomparable(row1, row2)) {
+    return false;
+  }
+  SDI_COUNT(DT, 1);
+  if (ranks_) {
+    auto ranks = (const char *) ranks_;
+    auto pitch = width_ * bytes_;
+    return rank_kernel_(ranks + row1 * pitch, ranks + row2 * pitch, width_);
+  }
+  if (layout_ == layout::column) {
+    // A scan of one row; its counts were already taken above.
+    view v{data_, bounds_, pitch_, stride_, width_};
+    K key = row1;
+    size_t dte = 0;
+    size_t dt = 0;
+    return scan_(v, &key, 1, row2, dte, dt);
+  }
+  return dominate_(&data_[row1 * width_], &data_[row2 * width_], width_);
+}
+
+auto db::dominated(const K *rows, size_t n, size_t row) -> bool {
+  if (mask_) {
+    for (size_t i = 0; i < n; ++i) {
+      if (masked_(rows[i], row)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if (ranks_) {
+    dense r{ranks_, bounds_, width_};
+    size_t dte = 0;
+    size_t dt = 0;
+    auto dominated = rank_(r, rows, n, row, dte, dt);
+    SDI_COUNT(DTE, dte);
+    SDI_COUNT(DT, dt);
+    return dominated;
+  }
+  if (layout_ == layout::column || scan_) {
+    view v{data_, bounds_, pitch_, stride_, width_};
+    size_t dte = 0;
+    size_t dt = 0;
+    auto dominated = scan_(v, rows, n, row, dte, dt);
+    SDI_COUNT(DTE, dte);
+    SDI_COUNT(DT, dt);
+    return dominated;
+  }
+  // Same tests and counts as calling dominate(rows[i], row) in turn, with
+  // the tested row and its bounds loaded once and the counts kept in
+  // registers until the end.
+  auto t = &data_[row * width_];
+  auto bt = &bounds_[row * BOUNDS];
+  auto min = bt[MIN];
+  auto sum = bt[SUM];
+  size_t dt = 0;
+  size_t i = 0;
+  for (; i < n; ++i) {
+    auto bs = &bounds_[rows[i] * BOUNDS];
+    if (!(bs[MIN] <= min && bs[SUM] <= sum)) {
+      continue;
+    }
+    ++dt;
+    if (dominate_(&data_[rows[i] * width_], t, width_)) {
+      break;
+    }
+  }
+  SDI_COUNT(DTE, i < n ? i + 1 : n);
+  SDI_COUNT(DT, dt);
+  return i < n;
 }
 
 auto db::empty() -> bool {
   return length_ == 0;
 }
 
+/**
+ * Reset the flags of one row for a new query, an erased row staying skipped.
+ */
+void db::clear(size_t row) {
+  skip_(row, erase_[row]);
+  skyline_(row, false);
+  test_(row, false);
+}
+
+/**
+ * Remove a row: it keeps its key and is skipped from now on.
+ */
+void db::erase(size_t row) {
+  erase_(row, true);
+  skip_(row, true);
+  skyline_(row, false);
+  checksum_ = 0;
+}
+
+auto db::erased(size_t row) const -> bool {
+  return erase_[row];
+}
+
+/**
+ * Fill all rows in place, row(i, values) writing the width() values of the
+ * row i, with the given number of threads.
+ */
+void db::fill(const std::function<void(size_t, double *)> &row, size_t threads) {
+  std::vector<double> staged(SDI_DB_STAGED ? height_ * width_ : 0);
+  parallel(threads, height_, [&](size_t first, size_t last) {
+    std::vector<double> values(width_);
+    for (size_t i = first; i < last; ++i) {
+      auto v = SDI_DB_STAGED ? &staged[i * width_] : values.data();
+      row(i, v);
+      if (!SDI_DB_STAGED) {
+        store_(i, v);
+      }
+    }
+  });
+  if (SDI_DB_STAGED) {
+    quantize_(staged, 0, height_, threads);
+  }
+  length_ = height_ * width_;
+  checksum_ = 0;
+}
+
+auto db::fingerprint() const -> unsigned long long {
+  // The checksum recorded in a binary dataset avoids hashing it again.
+  return checksum_ ? checksum_ : checksum();
+}
+
 auto db::height() const -> size_t {
   return height_;
 }
 
-auto db::incomparable(const V *s, const V *t) -> bool {
+auto db::incomparable(size_t s, size_t t) -> bool {
   // Returns true of a skyline s is incomparable with a testing tuple t.
-  return !(*(s + width_ + MIN) <= *(t + width_ + MIN) && *(s + width_ + SUM) <= *(t + width_ + SUM));
+  if (mask_) {
+    return false;
+  }
+  auto bs = &bounds_[s * BOUNDS];
+  auto bt = &bounds_[t * BOUNDS];
+  return !(bs[MIN] <= bt[MIN] && bs[SUM] <= bt[SUM]);
 }
 
 auto db::length() const -> size_t {
   return length_;
 }
 
+/**
+ * Bytes held by the database: values, bounds and row flags.
+ */
+auto db::memory() const -> size_t {
+  size_t flags = 4 * ((capacity_ + 63) / 64) * sizeof(unsigned long long);
+  size_t values = (layout_ == layout::row ? capacity_ : stride_) * width_;
+  return values * sizeof(V) + capacity_ * BOUNDS * sizeof(B) + flags;
+}
+
+/**
+ * Whether only a prefix of the rows of a binary file was loaded, which
+ * verify() cannot check against the checksum of the file.
+ */
+auto db::partial() const -> bool {
+  return partial_;
+}
+
+/**
+ * The value of the given dimension as stored: with WITH_QUANTIZED, the
+ * nearest step of the scale of the dimension. Rows loaded, read or filled
+ * set the scale to the range of their values, unless scale() was called;
+ * values appended later out of that range are clamped to its ends.
+ */
+auto db::quantize(size_t dimension, double value) const -> V {
+#ifdef WITH_QUANTIZED
+  auto steps = (value - origin_[dimension]) * scale_[dimension];
+  if (!(steps > 0)) {
+    return 0;
+  }
+  return steps < SDI_DB_STEPS ? (V) (steps + 0.5) : (V) SDI_DB_STEPS;
+#else
+  (void) dimension;
+  return (V) value;
+#endif
+}
+
+auto db::load(const char *filename, size_t threads) -> bool {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st{};
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return false;
+  }
+  auto size = (size_t) st.st_size;
+  if (!size) {
+    close(fd);
+    return true;
+  }
+  void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+  if (size >= sizeof(header) && !memcmp(map, SDI_DB_MAGIC, sizeof(header::magic))) {
+    return load_(map, size, threads);
+  }
+  // Only the text is read once from start to end, the binary rows are read
+  // randomly by the queries.
+  madvise(map, size, MADV_SEQUENTIAL);
+  auto text = (const char *) map;
+  auto end = text + size;
+  // Cut the text into newline-aligned chunks.
+  std::vector<const char *> chunks(threads + 1, end);
+  chunks[0] = text;
+  for (size_t t = 1; t < threads; ++t) {
+    auto p = text + size * t / threads;
+    if (p < chunks[t - 1]) {
+      p = chunks[t - 1];
+    }
+    auto eol = (const char *) memchr(p, '\n', end - p);
+    chunks[t] = eol ? eol + 1 : end;
+  }
+  // Count the rows of each chunk to know where each chunk starts in data_.
+  std::vector<size_t> rows(threads + 1, 0);
+  parallel(threads, [&](size_t t) {
+    size_t n = 0;
+    for (auto p = chunks[t]; p < chunks[t + 1];) {
+      auto eol = (const char *) memchr(p, '\n', chunks[t + 1] - p);
+      auto last = eol ? eol : chunks[t + 1];
+      if (!blank(p, last)) {
+        ++n;
+      }
+      p = last + 1;
+    }
+    rows[t + 1] = n;
+  });
+  for (size_t t = 0; t < threads; ++t) {
+    rows[t + 1] += rows[t];
+  }
+  std::vector<double> staged(SDI_DB_STAGED ? height_ * width_ : 0);
+  parallel(threads, [&](size_t t) {
+    std::vector<double> values(width_);
+    auto row = rows[t];
+    for (auto p = chunks[t]; p < chunks[t + 1] && row < height_;) {
+      auto eol = (const char *) memchr(p, '\n', chunks[t + 1] - p);
+      auto last = eol ? eol : chunks[t + 1];
+      if (!blank(p, last)) {
+        auto v = SDI_DB_STAGED ? &staged[row * width_] : values.data();
+        parse_(p, last, v);
+        if (!SDI_DB_STAGED) {
+          store_(row, v);
+        }
+        ++row;
+      }
+      p = last + 1;
+    }
+  });
+  munmap(map, size);
+  length_ = (rows[threads] < height_ ? rows[threads] : height_) * width_;
+  if (SDI_DB_STAGED) {
+    quantize_(staged, 0, length_ / width_, threads);
+  }
+  return true;
+}
+
+/**
+ * Test dominance on the dense ranks of the rows, of bytes bytes each, in
+ * place of their values; nullptr goes back to the values.
+ */
+void db::ranks(const void *ranks, size_t bytes) {
+  ranks_ = ranks;
+  bytes_ = bytes;
+  rank_kernel_ = ranks ? rank_kernel_select(bytes, width_) : nullptr;
+  rank_ = ranks ? rank_scan_select(bytes, width_) : nullptr;
+}
+
+auto db::save(const char *filename, layout l) const -> bool {
+  header h{};
+  memcpy(h.magic, SDI_DB_MAGIC, sizeof(h.magic));
+  h.version = SDI_DB_VERSION;
+  h.layout = (unsigned int) l;
+  h.kind = SDI_DB_KIND;
+  h.size = sizeof(V);
+  h.cardinality = size();
+  h.dimensionality = width_;
+  h.stride = l == layout::column ? (size() + SDI_DB_ALIGN - 1) / SDI_DB_ALIGN * SDI_DB_ALIGN : width_;
+  h.checksum = checksum();
+  std::ofstream out(filename, std::ios::binary);
+  out.write((const char *) &h, sizeof(h));
+  if (l == layout::row && layout_ == layout::row) {
+    out.write((const char *) data_, length_ * sizeof(V));
+  } else if (l == layout::row) {
+    std::vector<V> row(width_);
+    for (size_t i = 0; i < size(); ++i) {
+      for (size_t d = 0; d < width_; ++d) {
+        row[d] = data_[i * pitch_ + d * stride_];
+      }
+      out.write((const char *) row.data(), row.size() * sizeof(V));
+    }
+  } else {
+    std::vector<V> column(h.stride, 0);
+    for (size_t d = 0; d < width_; ++d) {
+      for (size_t i = 0; i < size(); ++i) {
+        column[i] = data_[i * pitch_ + d * stride_];
+      }
+      out.write((const char *) column.data(), column.size() * sizeof(V));
+    }
+  }
+  out.close();
+  return out.good();
+}
+
+/**
+ * Scale the quantized values of a dimension to [min, max], from the next
+ * rows stored on, in place of the range of the values loaded; rows already
+ * stored keep their values.
+ */
+void db::scale(size_t dimension, double min, double max) {
+  scaled_[dimension] = true;
+  origin_[dimension] = min;
+  scale_[dimension] = max > min ? SDI_DB_STEPS / (max - min) : SDI_DB_STEPS;
+}
+
 auto db::size() const -> size_t {
-  return length_ / (width_ + FLAGS);
+  return length_ / width_;
+}
+
+/**
+ * Mark a row as dominated from any thread.
+ */
+void db::skip(size_t row) {
+  skip_.set(row);
 }
 
 auto db::skipped(size_t row) const -> bool {
-  return data_[row * (width_ + FLAGS) + width_ + SKIP] > 0;
+  return skip_[row];
 }
+
 void db::skipped(size_t row, bool flag) {
-  data_[row * (width_ + FLAGS) + width_ + SKIP] = flag;
+  skip_(row, flag);
 }
 
 auto db::skyline(size_t row) const -> bool {
-  return data_[row * (width_ + FLAGS) + width_ + SKYLINE] > 0;
+  return skyline_[row];
 }
 
 void db::skyline(size_t row, bool flag) {
-  data_[row * (width_ + FLAGS) + width_ + SKYLINE] = flag;
+  skyline_(row, flag);
+}
+
+/**
+ * Reset the flags of all rows for a new query, erased rows being skipped,
+ * and all rows but the given ones if any.
+ */
+void db::reset(const std::vector<K> *rows) {
+  skip_.clear();
+  skyline_.clear();
+  test_.clear();
+  for (size_t i = 0; i < height_; ++i) {
+    if (rows || erase_[i]) {
+      skip_(i, true);
+    }
+  }
+  for (size_t i = 0; rows && i < rows->size(); ++i) {
+    skip_((*rows)[i], erase_[(*rows)[i]]);
+  }
+}
+
+auto db::subspace() const -> MASK {
+  return mask_;
+}
+
+/**
+ * Restrict dominance tests to the given dimensions. Bounds are those of
+ * the whole space, so the MIN/SUM filter is off within a subspace.
+ */
+void db::subspace(MASK mask) {
+  MASK all = width_ < 64 ? (1ULL << width_) - 1 : ~0ULL;
+  mask_ = (mask & all) == all ? 0 : mask & all;
+}
+
+auto db::sum(size_t row) const -> B {
+  return bounds_[row * BOUNDS + SUM];
 }
 
 auto db::tested(size_t row) const -> bool {
-  return data_[row * (width_ + FLAGS) + width_ + TEST] > 0;
+  return test_[row];
 }
+
 void db::tested(size_t row, bool flag) {
-  data_[row * (width_ + FLAGS) + width_ + TEST] = flag;
+  test_(row, flag);
+}
+
+/**
+ * The value of a row in the given dimension, back on the scale of the
+ * dimension when quantized.
+ */
+auto db::value(size_t row, size_t dimension) const -> double {
+  auto value = data_[row * pitch_ + dimension * stride_];
+#ifdef WITH_QUANTIZED
+  return origin_[dimension] + value / scale_[dimension];
+#else
+  return value;
+#endif
+}
+
+/**
+ * Mark a row as tested from any thread, returns true for the first caller.
+ */
+auto db::visit(size_t row) -> bool {
+  return !test_.set(row);
+}
+
+/**
+ * Returns true if the rows match the checksum of the file, if any, a prefix of
+ * a binary file never does.
+ */
+auto db::verify() const -> bool {
+  return !partial_ && (!checksum_ || checksum_ == checksum());
 }
 
 auto db::width() const -> size_t {
   return width_;
 }
 
+/**
+ * The values of a row, adjacent on the row layout only; use operator()(row,
+ * dimension) on the column layout.
+ */
 auto db::operator()(size_t row) -> V * {
-  ++IO;
-  return &data_[row * (width_ + FLAGS)];
+  assert(layout_ == layout::row);
+  SDI_COUNT(IO, 1);
+  return &data_[row * pitch_];
 }
 
 auto db::operator()(size_t row) const -> V * {
-  ++IO;
-  return &data_[row * (width_ + FLAGS)];
+  assert(layout_ == layout::row);
+  SDI_COUNT(IO, 1);
+  return &data_[row * pitch_];
 }
 
+auto db::operator()(size_t row, size_t dimension) const -> V {
+  return data_[row * pitch_ + dimension * stride_];
+}
+
+/**
+ * Writable access to a value, copying mapped or viewed rows to owned storage
+ * first, as append() does.
+ */
 auto db::operator[](size_t n) -> V & {
+  if (!owned_ || map_) {
+    grow_(capacity_);
+  }
   return data_[n];
 }
 
-auto db::operator[](size_t n) const -> V & {
+auto db::operator[](size_t n) const -> const V & {
   return data_[n];
 }
 
-void db::put_(V x) {
-  data_[length_++] = x;
+void db::summary_(size_t row) {
+  auto values = &data_[row * pitch_];
+#ifdef WITH_QUANTIZED
+  B min = SDI_DB_STEPS;
+#else
+  B min = 1;
+#endif
+  B sum = 0;
+  for (size_t i = 0; i < width_; ++i) {
+    auto value = values[i * stride_];
+    if (value < min) {
+      min = value;
+    }
+    sum += value;
+  }
+  auto bounds = &bounds_[row * BOUNDS];
+  bounds[MIN] = min;
+  bounds[SUM] = sum;
+}
+
+void db::grow_(size_t capacity) {
+  size_t pitch = layout_ == layout::row ? width_ : 1;
+  size_t stride = layout_ == layout::row ? 1 : (capacity + SDI_DB_ALIGN - 1) / SDI_DB_ALIGN * SDI_DB_ALIGN;
+  size_t values = (layout_ == layout::row ? capacity : stride) * width_;
+  void *data = nullptr;
+  if (posix_memalign(&data, SDI_DB_ALIGN * sizeof(V), values * sizeof(V))) {
+    throw std::bad_alloc();
+  }
+  auto grown = (V *) data;
+  auto bounds = new B[capacity * BOUNDS];
+  for (size_t i = 0; i < height_; ++i) {
+    for (size_t d = 0; d < width_; ++d) {
+      grown[i * pitch + d * stride] = data_[i * pitch_ + d * stride_];
+    }
+    for (size_t b = 0; b < BOUNDS; ++b) {
+      bounds[i * BOUNDS + b] = bounds_[i * BOUNDS + b];
+    }
+  }
+  if (owned_) {
+    if (map_) {
+      munmap(map_, mapped_);
+    } else {
+      free(data_);
+    }
+    delete[] bounds_;
+  }
+  map_ = nullptr;
+  mapped_ = 0;
+  owned_ = true;
+  data_ = grown;
+  bounds_ = bounds;
+  pitch_ = pitch;
+  stride_ = stride;
+  capacity_ = capacity;
+  erase_.resize(capacity);
+  skip_.resize(capacity);
+  skyline_.resize(capacity);
+  test_.resize(capacity);
+}
+
+auto db::masked_(size_t row1, size_t row2) -> bool {
+  SDI_COUNT(DTE, 1);
+  SDI_COUNT(DT, 1);
+  auto p1 = &data_[row1 * pitch_];
+  auto p2 = &data_[row2 * pitch_];
+  bool better = false;
+  for (auto m = mask_; m; m &= m - 1) {
+    auto d = (size_t) __builtin_ctzll(m) * stride_;
+    if (p1[d] > p2[d]) {
+      return false;
+    }
+    if (p1[d] < p2[d]) {
+      better = true;
+    }
+  }
+  return better;
+}
+
+auto db::load_(void *map, size_t size, size_t threads) -> bool {
+  header h{};
+  memcpy(&h, map, sizeof(h));
+  bool columns = h.layout == (unsigned int) layout::column;
+  size_t stride = columns ? h.stride : h.dimensionality;
+  size_t count = columns ? stride * h.dimensionality : h.cardinality * stride;
+  if (h.version != SDI_DB_VERSION || h.layout > (unsigned int) layout::column || h.kind != SDI_DB_KIND ||
+      h.size != sizeof(V) || h.dimensionality != width_ || h.cardinality < height_ ||
+      (columns && stride < h.cardinality) || size < sizeof(h) + count * sizeof(V)) {
+    munmap(map, size);
+    return false;
+  }
+  auto values = (V *) ((char *) map + sizeof(h));
+  if (columns == (layout_ == layout::column) && (!columns || stride == stride_)) {
+    // Run on the mapped values directly.
+    free(data_);
+    data_ = values;
+    map_ = map;
+    mapped_ = size;
+  } else {
+    size_t pitch = columns ? 1 : stride;
+    size_t step = columns ? stride : 1;
+    parallel(threads, height_, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        for (size_t d = 0; d < width_; ++d) {
+          data_[i * pitch_ + d * stride_] = values[i * pitch + d * step];
+        }
+      }
+    });
+    munmap(map, size);
+  }
+  length_ = height_ * width_;
+  // The checksum covers all the rows of the file, not a prefix of them.
+  partial_ = h.cardinality != height_;
+  checksum_ = partial_ ? 0 : h.checksum;
+  parallel(threads, height_, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      summary_(i);
+    }
+  });
+  return true;
+}
+
+/**
+ * Parse the width() values of a line, missing ones being 0.
+ */
+void db::parse_(const char *first, const char *last, double *values) const {
+  auto p = first;
+  for (size_t i = 0; i < width_; ++i) {
+    while (p < last && delimiter(*p)) {
+      ++p;
+    }
+    double value = 0;
+    if (p < last) {
+      value = number(p, last, &p);
+      while (p < last && !delimiter(*p)) {
+        ++p;
+      }
+    }
+    values[i] = value;
+  }
+}
+
+/**
+ * Scale each dimension not given to scale() to the range of the staged
+ * values of rows [first, last), when they are the first rows, then store
+ * these rows with the given number of threads.
+ */
+void db::quantize_(const std::vector<double> &staged, size_t first, size_t last, size_t threads) {
+  for (size_t d = 0; d < width_ && !first && last; ++d) {
+    if (scaled_[d]) {
+      continue;
+    }
+    double min = staged[d];
+    double max = staged[d];
+    for (size_t i = 1; i < last; ++i) {
+      auto value = staged[i * width_ + d];
+      min = value < min ? value : min;
+      max = value > max ? value : max;
+    }
+    origin_[d] = min;
+    scale_[d] = max > min ? SDI_DB_STEPS / (max - min) : SDI_DB_STEPS;
+  }
+  parallel(threads, last - first, [&](size_t begin, size_t end) {
+    for (size_t i = first + begin; i < first + end; ++i) {
+      store_(i, &staged[i * width_]);
+    }
+  });
+}
+
+/**
+ * Store the width() values of a row, quantized with WITH_QUANTIZED.
+ */
+void db::store_(size_t row, const double *values) {
+  for (size_t d = 0; d < width_; ++d) {
+    data_[row * pitch_ + d * stride_] = quantize(d, values[d]);
+  }
+  summary_(row);
 }
 
 }
@@ -29,49 +29,110 @@
 #ifndef SDI_DB_H
 #define SDI_DB_H
 
+#include <functional>
 #include <iostream>
+#include <vector>
+#include "sdi-bitset.h"
+#include "sdi-kernel.h"
+#include "sdi-stats.h"
 #include "sdi-types.h"
 
 namespace sdibench {
 
+enum class layout {
+  row, column
+};
+
 class db {
   friend auto operator>>(std::istream &, db &) -> std::istream &;
   friend auto operator<<(std::ostream &, const db &) -> std::ostream &;
 public:
-  static size_t DT; // Dominance Test count
-  static size_t DTE; // Dominance Test Extended count
-  static size_t IO; // IO count
-  static size_t SKY; // Skyline size
-  static size_t STOP; // Stop line count
-  static size_t TT; // Tested tuple count
   db() = default;
   explicit db(size_t, size_t);
+  explicit db(size_t, size_t, layout);
+  explicit db(db &, size_t, size_t);
+  explicit db(const db &, const std::vector<K> &);
   virtual ~db();
+  auto append(const V *) -> K;
+  auto checksum() const -> unsigned long long;
+  auto claim(size_t) -> bool;
+  void clear(size_t);
   auto dominate(V *, V *) -> bool;
   auto dominate(V *, size_t) -> bool;
   auto dominate(size_t, size_t) -> bool;
+  auto dominated(const K *, size_t, size_t) -> bool;
   auto empty() -> bool;
+  void erase(size_t);
+  auto erased(size_t) const -> bool;
+  void fill(const std::function<void(size_t, double *)> &, size_t);
+  void reset(const std::vector<K> * = nullptr);
+  auto fingerprint() const -> unsigned long long;
   auto height() const -> size_t;
-  auto incomparable(const V *, const V *) -> bool ;
+  auto incomparable(size_t, size_t) -> bool;
   auto length() const -> size_t;
+  auto load(const char *, size_t) -> bool;
+  auto memory() const -> size_t;
+  auto partial() const -> bool;
+  auto quantize(size_t, double) const -> V;
+  void ranks(const void *, size_t);
+  auto save(const char *, layout) const -> bool;
+  void scale(size_t, double, double);
   auto size() const -> size_t;
+  void skip(size_t);
+  auto subspace() const -> MASK;
+  void subspace(MASK);
+  auto sum(size_t) const -> B;
   auto skipped(size_t) const -> bool;
   void skipped(size_t, bool);
   auto skyline(size_t) const -> bool;
   void skyline(size_t, bool);
   auto tested(size_t) const -> bool;
   void tested(size_t, bool);
+  auto value(size_t, size_t) const -> double;
+  auto visit(size_t) -> bool;
+  auto verify() const -> bool;
   auto width() const -> size_t;
   auto operator()(size_t) -> V *;
   auto operator()(size_t) const -> V *;
+  auto operator()(size_t, size_t) const -> V;
   auto operator[](size_t) -> V &;
-  auto operator[](size_t) const -> V &;
+  auto operator[](size_t) const -> const V &;
 private:
-  void put_(V);
-  V *data_ = nullptr;
+  void grow_(size_t);
+  auto load_(void *, size_t, size_t) -> bool;
+  auto masked_(size_t, size_t) -> bool;
+  void parse_(const char *, const char *, double *) const;
+  void quantize_(const std::vector<double> &, size_t, size_t, size_t);
+  void store_(size_t, const double *);
+  void summary_(size_t);
+  kernel dominate_ = kernel_select();
+  scan scan_ = nullptr; // By columns, or by rows of a fixed width.
+  rank_kernel rank_kernel_ = nullptr;
+  rank_scan rank_ = nullptr;
+  const void *ranks_ = nullptr; // Dense ranks by rows, owned by the index.
+  size_t bytes_ = 0; // The size of a dense rank.
+  V *data_ = nullptr; // Values, by rows or by columns.
+  B *bounds_ = nullptr; // Min and sum values, row by row.
+  void *map_ = nullptr;
+  size_t mapped_ = 0;
+  bool owned_ = true; // False for a view on the rows of another db.
+  unsigned long long checksum_ = 0;
+  bool partial_ = false; // A prefix of a binary file, which has no checksum.
+  size_t capacity_ = 0; // Rows allocated, height_ of them being used.
   size_t height_ = 0;
   size_t length_ = 0;
   size_t width_ = 0;
+  std::vector<double> origin_; // The lowest value of each dimension, when quantized.
+  std::vector<double> scale_; // The steps per unit of each dimension, when quantized.
+  std::vector<bool> scaled_; // Dimensions given to scale(), the others take the range of their values.
+  layout layout_ = layout::row;
+  size_t pitch_ = 0; // Distance between two rows in data_.
+  size_t stride_ = 0; // Distance between two values of a row in data_.
+  MASK mask_ = 0; // Dimensions of dominance tests, 0 for all of them.
+  bitset erase_;
+  bitset skip_;
+  bitset skyline_;
+  bitset test_;
 };
 
 }
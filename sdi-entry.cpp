@@ -34,13 +34,19 @@ namespace sdibench {
 entry::entry(K k) : key(k) {
 }
 
+#ifndef WITHOUT_INDEX_VALUE
 entry::entry(K k, V v) : key(k), value(v) {
 }
+#else
+entry::entry(K k, V) : key(k) {
+}
+#endif
 
 auto operator==(const entry &e1, const entry &e2) -> bool {
   return e1.key == e2.key;
 }
 
+#ifndef WITHOUT_INDEX_VALUE
 auto operator<(const entry &e1, const entry &e2) -> bool {
   if (e1.value == e2.value) {
     return e1.key < e2.key;
@@ -52,5 +58,15 @@ auto operator<<(std::ostream &out, const entry &e) -> std::ostream & {
   out << e.value << ":" << e.key;
   return out;
 }
+#else
+auto operator<(const entry &e1, const entry &e2) -> bool {
+  return e1.key < e2.key;
+}
+
+auto operator<<(std::ostream &out, const entry &e) -> std::ostream & {
+  out << e.key;
+  return out;
+}
+#endif
 
 }
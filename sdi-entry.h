@@ -33,9 +33,13 @@
 
 namespace sdibench {
 
+// Without the index value, an entry is its key alone and the value is read
+// from the database, see index::value().
 struct entry {
   K key = 0;
+#ifndef WITHOUT_INDEX_VALUE
   V value = 0;
+#endif
   entry() = default;
   explicit entry(K);
   entry(K, V);
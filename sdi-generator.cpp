@@ -0,0 +1,138 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <cstring>
+#include "sdi-generator.h"
+
+namespace sdibench {
+
+// A splitmix64 stream, cheap to seed once per row.
+static auto next(unsigned long long &state) -> unsigned long long {
+  auto z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Uniform in [min, max).
+static auto equal(unsigned long long &state, double min, double max) -> double {
+  return min + (double) (next(state) >> 11) * (1.0 / 9007199254740992.0) * (max - min);
+}
+
+// Mean of n uniform values in [min, max), peaked around the middle.
+static auto peak(unsigned long long &state, double min, double max, size_t n) -> double {
+  double sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sum += equal(state, 0, 1);
+  }
+  return min + sum / n * (max - min);
+}
+
+// Nearly normal around med, within [med - var, med + var].
+static auto normal(unsigned long long &state, double med, double var) -> double {
+  return peak(state, med - var, med + var, 12);
+}
+
+static auto inside(const double *values, size_t dimensionality) -> bool {
+  for (size_t d = 0; d < dimensionality; ++d) {
+    if (values[d] < 0 || values[d] > 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+generator::generator(distribution distribution, unsigned long long seed) : distribution_(distribution),
+                                                                         seed_(seed) {
+}
+
+/**
+ * Fill all rows of the database.
+ */
+void generator::generate(db &db, size_t threads) const {
+  auto dimensionality = db.width();
+  db.fill([&](size_t i, double *values) {
+    row(i, values, dimensionality);
+  }, threads);
+}
+
+auto generator::name() const -> const char * {
+  switch (distribution_) {
+  case distribution::correlated:
+    return "correlated";
+  case distribution::anticorrelated:
+    return "anti-correlated";
+  default:
+    return "independent";
+  }
+}
+
+/**
+ * Read a distribution by name or by its initial, I, C or A.
+ */
+auto generator::parse(const char *name, distribution &distribution) -> bool {
+  if (!strcmp(name, "independent") || !strcmp(name, "I")) {
+    distribution = distribution::independent;
+  } else if (!strcmp(name, "correlated") || !strcmp(name, "C")) {
+    distribution = distribution::correlated;
+  } else if (!strcmp(name, "anti-correlated") || !strcmp(name, "anticorrelated") || !strcmp(name, "A")) {
+    distribution = distribution::anticorrelated;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * The values of the row i. Correlated and anti-correlated tuples move
+ * from a point of the diagonal by pairs of opposite shifts, and are drawn
+ * again until all of their values are in [0, 1].
+ */
+void generator::row(size_t i, double *values, size_t dimensionality) const {
+  unsigned long long s = seed_ ^ (i + 1) * 0xd1b54a32d192ed03ULL;
+  if (distribution_ == distribution::independent) {
+    for (size_t d = 0; d < dimensionality; ++d) {
+      values[d] = equal(s, 0, 1);
+    }
+    return;
+  }
+  do {
+    auto v = distribution_ == distribution::correlated ? peak(s, 0, 1, dimensionality) : normal(s, 0.5, 0.25);
+    auto l = v <= 0.5 ? v : 1 - v;
+    for (size_t d = 0; d < dimensionality; ++d) {
+      values[d] = v;
+    }
+    for (size_t d = 0; d < dimensionality; ++d) {
+      auto h = distribution_ == distribution::correlated ? normal(s, 0, l) : equal(s, -l, l);
+      values[d] += h;
+      values[(d + 1) % dimensionality] -= h;
+    }
+  } while (!inside(values, dimensionality));
+}
+
+}
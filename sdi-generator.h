@@ -0,0 +1,62 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef SDI_GENERATOR_H
+#define SDI_GENERATOR_H
+
+#include <cstddef>
+#include "sdi-db.h"
+
+namespace sdibench {
+
+enum class distribution {
+  independent, correlated, anticorrelated
+};
+
+/**
+ * Synthetic datasets of the standard skyline distributions, as generated
+ * by Borzsonyi et al. for the skyline operator: values are in [0, 1],
+ * correlated tuples lie near the diagonal and anti-correlated ones near
+ * the plane of sum d/2. Each row draws from its own stream of the seed, so
+ * that the data do not depend on the number of threads.
+ */
+class generator {
+public:
+  explicit generator(distribution, unsigned long long);
+  void generate(db &, size_t) const;
+  auto name() const -> const char *;
+  static auto parse(const char *, distribution &) -> bool;
+  void row(size_t, double *, size_t) const;
+private:
+  distribution distribution_;
+  unsigned long long seed_;
+};
+
+}
+
+#endif //SDI_GENERATOR_H
@@ -26,18 +26,78 @@
  * $Id: sdi-index.cpp 566 2019-12-23 15:12:34Z li $
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "sdi-db.h"
 #include "sdi-entry.h"
 #include "sdi-index.h"
+#include "parallel.h"
 #include "sort.h"
+#include "timer.h"
+
+#define SDI_INDEX_MAGIC "SDIINDEX"
+#define SDI_INDEX_VERSION 2
+#define SDI_INDEX_SIGNATURE 64
 
 namespace sdibench {
 
+/**
+ * Header of an index snapshot, followed by the dimension index I and the
+ * offset list O as they are laid out in memory.
+ */
+struct snapshot {
+  char magic[8];
+  unsigned int version;
+  unsigned int key;
+  unsigned int value;
+  unsigned int entry;
+  unsigned int rank;
+  unsigned int pad;
+  unsigned long long cardinality;
+  unsigned long long dimensionality;
+  unsigned long long fingerprint;
+  unsigned long long offset;
+  unsigned long long reserved;
+};
+
 index::index(db &db) : D_(db), cardinality_(db.height()), dimensionality_(db.width()) {
   I_ = new block<entry>(dimensionality_, cardinality_);
-  O_ = new block<size_t>(cardinality_, dimensionality_ + 2);
-  S_ = new block<V *>(dimensionality_, cardinality_);
+  O_ = new block<OFFSET>(cardinality_, dimensionality_ + 2);
+  S_ = new std::vector<point>[dimensionality_];
+  // Share the 64 signature bits between dimensions.
+  levels_ = dimensionality_ ? SDI_INDEX_SIGNATURE / dimensionality_ : 0;
+  skyline_ = new size_t[dimensionality_];
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    skyline_[d] = 0;
+  }
+  stop_ = new bool[dimensionality_];
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    stop_[d] = false;
+  }
+}
+
+/**
+ * An index of the rows of db sharing the lists, offsets and dense ranks of
+ * source, an index of the same rows that must outlive it, with its own
+ * dimensional skylines and stop flags: both may be queried concurrently as
+ * long as neither is updated.
+ */
+index::index(db &db, const index &source) : D_(db), T_(source.T_), bytes_(source.bytes_), dense_(source.dense_),
+                                            owned_(false), cardinality_(source.cardinality_),
+                                            dimensionality_(source.dimensionality_), levels_(source.levels_) {
+  I_ = source.I_;
+  O_ = source.O_;
+  S_ = new std::vector<point>[dimensionality_];
   skyline_ = new size_t[dimensionality_];
   for (size_t d = 0; d < dimensionality_; ++d) {
     skyline_[d] = 0;
@@ -46,20 +106,29 @@ index::index(db &db) : D_(db), cardinality_(db.height()), dimensionality_(db.wid
   for (size_t d = 0; d < dimensionality_; ++d) {
     stop_[d] = false;
   }
+  if (!source.R_.empty()) {
+    D_.ranks(source.R_.data(), bytes_);
+  }
 }
 
 index::~index() {
-  delete I_;
-  delete O_;
-  delete S_;
+  delete[] S_;
   delete[] skyline_;
   delete[] stop_;
+  if (!owned_) {
+    return;
+  }
+  delete I_;
+  delete O_;
+  if (map_) {
+    munmap(map_, mapped_);
+  }
 }
 
 auto index::best() -> size_t {
-  size_t b = 0;
+  size_t b = mask_ ? (size_t) __builtin_ctzll(mask_) : 0;
   for (size_t d = 0; d < dimensionality_; ++d) {
-    if (stop_[d]) {
+    if (stop_[d] || (mask_ && !(mask_ >> d & 1))) {
       continue;
     }
     if (skyline_[d] < skyline_[b]) {
@@ -69,68 +138,315 @@ auto index::best() -> size_t {
   return b;
 }
 
-void index::build() {
+void index::build(size_t threads) {
   auto &I = *I_;
   auto &O = *O_;
-  auto &S = *S_;
-  for (size_t i = 0; i < cardinality_; ++i) {
-    auto row = D_(i);
-    for (size_t d = 0; d < dimensionality_; ++d) {
-      I(d, i).key = i;
-      I(d, i).value = row[d];
-    }
+  if (threads < 1) {
+    threads = 1;
   }
-  for (size_t d = 0; d < dimensionality_; ++d) {
-    msort(I(d), cardinality_);
+  {
+    phase p("fill");
+    parallel(threads, cardinality_, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        for (size_t d = 0; d < dimensionality_; ++d) {
+          I(d, i) = entry(i, D_(i, d));
+        }
+      }
+    });
+    SDI_COUNT(IO, cardinality_);
   }
-  for (size_t d = 0; d < dimensionality_; ++d) {
-    for (size_t i = 0; i < cardinality_; ++i) {
-      auto row = O(I(d, i).key);
-      auto &max = row[dimensionality_];
-      auto &mean = row[dimensionality_ + 1];
-      row[d] = i;
-      if (max < i) {
-        max = i;
+  // Sort dimensions concurrently, spare threads go to sort each dimension.
+  size_t sorters = threads < dimensionality_ ? threads : dimensionality_;
+  size_t helpers = threads / dimensionality_;
+  std::atomic<size_t> next(0);
+  {
+    phase p("sort");
+    parallel(sorters, [&](size_t) {
+      for (size_t d = next++; d < dimensionality_; d = next++) {
+        auto less = [&](const entry &x, const entry &y) {
+          auto vx = value(d, x);
+          auto vy = value(d, y);
+          return vx < vy || (vx == vy && x.key < y.key);
+        };
+#ifdef WITH_MSORT
+        psort(I(d), cardinality_, helpers, [&](entry *x, size_t n) {
+          msort(x, n, less);
+        }, less);
+#else
+        // Entries are filled in key order, so a stable sort on the value
+        // alone yields the (value, key) order.
+        psort(I(d), cardinality_, helpers, [&](entry *x, size_t n) {
+          rsort(x, n, [&](const entry &e) {
+            return radix(value(d, e));
+          });
+        }, less);
+#endif
       }
-      mean += i;
-    }
+    });
   }
+  phase p("offsets");
+  // Offsets are written column by column, then max and mean row by row.
+  next = 0;
+  parallel(sorters, [&](size_t) {
+    for (size_t d = next++; d < dimensionality_; d = next++) {
+      for (size_t i = 0; i < cardinality_; ++i) {
+        O(I(d, i).key, d) = (OFFSET) i;
+      }
+    }
+  });
+  thresholds_();
+  ranks_(threads);
+  densify_(threads);
+}
+
+/**
+ * Let the database test dominance on dense ranks, from the next build,
+ * load or sync on.
+ */
+void index::dense(bool enabled) {
+  dense_ = enabled;
 }
 
 auto index::dominate(size_t d, K key) -> bool {
-  auto &&s = (*S_)(d);
-  for (size_t i = 0; i < cardinality_; ++i) {
-    if (!s[i]) {
-      return false;
+#ifdef WITH_PHASES
+  phase p("dominance");
+#endif
+  // Only skyline tuples with a lower sum and a subset signature may
+  // dominate the tuple; they are tested by batches.
+  const size_t batch = 64;
+  K candidates[batch];
+  size_t n = 0;
+  auto sum = sum_(key);
+  auto signature = signature_(key);
+  for (auto &&p : S_[d]) {
+    if (p.sum > sum) {
+      break;
     }
-    if (D_.dominate(s[i], key)) {
-      return true;
+    if (p.signature & ~signature) {
+      continue;
+    }
+    candidates[n++] = p.key;
+    if (n == batch) {
+      if (D_.dominated(candidates, n, key)) {
+        return true;
+      }
+      n = 0;
+    }
+  }
+  return n && D_.dominated(candidates, n, key);
+}
+
+/**
+ * The number of tuples of the dimensional skyline d that dominate the
+ * tuple key, counted up to limit.
+ */
+auto index::dominators(size_t d, K key, size_t limit) -> size_t {
+#ifdef WITH_PHASES
+  phase p("dominance");
+#endif
+  size_t n = 0;
+  auto sum = sum_(key);
+  auto signature = signature_(key);
+  for (auto &&p : S_[d]) {
+    if (p.sum > sum) {
+      break;
+    }
+    if (p.signature & ~signature) {
+      continue;
+    }
+    if (D_.dominate(p.key, key) && ++n == limit) {
+      break;
     }
   }
-  return false;
+  return n;
 }
 
 void index::dump(std::ostream &out) {
   auto &I = *I_;
   for (size_t i = 0; i < cardinality_; ++i) {
-    out << I(0, i).key << ":" << I(0, i).value;
+    out << I(0, i).key << ":" << value(0, I(0, i));
     for (size_t d = 1; d < dimensionality_; ++d) {
-      out << " " << I(d, i).key << ":" << I(d, i).value;
+      out << " " << I(d, i).key << ":" << value(d, I(d, i));
     }
     out << std::endl;
   }
 }
 
+/**
+ * Whether a dataset of the given size can be indexed: keys must hold the
+ * cardinality and offsets the sum of the ranks of a tuple.
+ */
+auto index::fits(size_t cardinality, size_t dimensionality) -> bool {
+  auto limit = (unsigned long long) (OFFSET) -1;
+  return cardinality <= (unsigned long long) (K) -1 && cardinality * (dimensionality + 1) <= limit;
+}
+
+/**
+ * Add a row appended to the database. It stays pending, out of the sorted
+ * lists, until the next sync().
+ */
+void index::insert(K key) {
+  P_.push_back(key);
+}
+
 auto index::height() const -> size_t {
   return cardinality_;
 }
 
-auto index::offsets(K key) const -> size_t * {
+auto index::load(const char *filename) -> bool {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st{};
+  if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(snapshot)) {
+    close(fd);
+    return false;
+  }
+  auto size = (size_t) st.st_size;
+  // Private mapping: pages stay shared through the page cache until written.
+  void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  snapshot h{};
+  memcpy(&h, map, sizeof(h));
+  size_t entries = cardinality_ * dimensionality_ * sizeof(entry);
+  size_t offsets = cardinality_ * (dimensionality_ + 2) * sizeof(OFFSET);
+  if (memcmp(h.magic, SDI_INDEX_MAGIC, sizeof(h.magic)) != 0 || h.version != SDI_INDEX_VERSION ||
+      h.key != sizeof(K) || h.value != sizeof(V) || h.entry != sizeof(entry) || h.rank != sizeof(OFFSET) ||
+      h.cardinality != cardinality_ ||
+      h.dimensionality != dimensionality_ || h.fingerprint != D_.fingerprint() || h.offset != sizeof(h) + entries ||
+      size < h.offset + offsets) {
+    munmap(map, size);
+    return false;
+  }
+  delete I_;
+  delete O_;
+  I_ = new block<entry>(dimensionality_, cardinality_, (entry *) ((char *) map + sizeof(h)));
+  O_ = new block<OFFSET>(cardinality_, dimensionality_ + 2, (OFFSET *) ((char *) map + h.offset));
+  if (map_) {
+    munmap(map_, mapped_);
+  }
+  map_ = map;
+  mapped_ = size;
+  thresholds_();
+  densify_(1);
+  return true;
+}
+
+/**
+ * Bytes held by the index: the dimension index, the offset list, the
+ * dimensional skylines and the dense ranks, mapped snapshots included.
+ */
+auto index::memory() const -> size_t {
+  size_t size = cardinality_ * dimensionality_ * sizeof(entry);
+  size += cardinality_ * (dimensionality_ + 2) * sizeof(OFFSET);
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    size += S_[d].capacity() * sizeof(point);
+  }
+  return size + T_.capacity() * sizeof(V) + R_.capacity();
+}
+
+auto index::offsets(K key) const -> OFFSET * {
   return (*O_)(key);
 }
 
+auto index::pending() const -> size_t {
+  return P_.size();
+}
+
+/**
+ * Collect the live tuples dominated by the tuple key, pending or not: they
+ * are pending, or they follow the first tuple of the value of key in the
+ * dimension where that value ranks last.
+ */
+void index::region(K key, std::vector<K> &rows) {
+  entry *first = nullptr;
+  entry *last = nullptr;
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    if (mask_ && !(mask_ >> d & 1)) {
+      continue;
+    }
+    auto list = (*I_)(d);
+    auto v = D_(key, d);
+    auto at = std::lower_bound(list, list + cardinality_, v, [&](const entry &e, V x) {
+      return value(d, e) < x;
+    });
+    if (!first || at - list > first - (last - cardinality_)) {
+      first = at;
+      last = list + cardinality_;
+    }
+  }
+  auto test = [&](K k) {
+    if (k != key && !D_.erased(k) && !D_.skyline(k) && !D_.incomparable(key, k) && D_.dominate(key, k)) {
+      rows.push_back(k);
+    }
+  };
+  for (auto e = first; e < last; ++e) {
+    test(e->key);
+  }
+  for (auto &&k : P_) {
+    test(k);
+  }
+}
+
+/**
+ * Clear the dimensional skylines and the stop flags for a new query.
+ */
+void index::reset() {
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    S_[d].clear();
+    skyline_[d] = 0;
+  }
+  stop();
+}
+
+auto index::save(const char *filename) const -> bool {
+  snapshot h{};
+  size_t entries = cardinality_ * dimensionality_ * sizeof(entry);
+  size_t offsets = cardinality_ * (dimensionality_ + 2) * sizeof(OFFSET);
+  memcpy(h.magic, SDI_INDEX_MAGIC, sizeof(h.magic));
+  h.version = SDI_INDEX_VERSION;
+  h.key = sizeof(K);
+  h.value = sizeof(V);
+  h.entry = sizeof(entry);
+  h.rank = sizeof(OFFSET);
+  h.cardinality = cardinality_;
+  h.dimensionality = dimensionality_;
+  h.fingerprint = D_.fingerprint();
+  h.offset = sizeof(h) + entries;
+  // Written aside then renamed over the snapshot, which another process may
+  // have mapped: it never sees a truncated or partial file.
+  std::string temporary = std::string(filename) + ".XXXXXX";
+  int fd = mkstemp(&temporary[0]);
+  if (fd < 0) {
+    return false;
+  }
+  // As readable as a file created by std::ofstream, mkstemp() being private.
+  fchmod(fd, 0644);
+  close(fd);
+  std::ofstream out(temporary, std::ios::binary);
+  out.write((const char *) &h, sizeof(h));
+  out.write((const char *) (*I_)(0), entries);
+  out.write((const char *) (*O_)(0), offsets);
+  out.close();
+  if (!out.good() || rename(temporary.c_str(), filename) != 0) {
+    remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
 void index::skyline(size_t d, K key) {
-  (*S_)(d)[skyline_[d]++] = D_(key);
+  point p{sum_(key), signature_(key), key};
+  auto &s = S_[d];
+  auto at = std::upper_bound(s.begin(), s.end(), p, [](const point &x, const point &y) {
+    return x.sum < y.sum;
+  });
+  s.insert(at, p);
+  ++skyline_[d];
 }
 
 void index::stop() {
@@ -139,6 +455,21 @@ void index::stop() {
   }
 }
 
+/**
+ * Restrict the query to the given dimensions: best() and stop() skip the
+ * others, sums and signatures of the dimensional skylines ignore them.
+ */
+void index::subspace(MASK mask) {
+  MASK all = dimensionality_ < 64 ? (1ULL << dimensionality_) - 1 : ~0ULL;
+  mask_ = (mask & all) == all ? 0 : mask & all;
+  bits_ = mask_ ? 0 : ~0ULL;
+  for (size_t d = 0; d < dimensionality_ && mask_; ++d) {
+    if (mask_ >> d & 1) {
+      bits_ |= ((1ULL << levels_) - 1) << (d * levels_);
+    }
+  }
+}
+
 auto index::stop(size_t dimension) -> size_t {
   stop_[dimension] = true;
   size_t s = 0;
@@ -150,6 +481,163 @@ auto index::stop(size_t dimension) -> size_t {
   return s;
 }
 
+/**
+ * Merge the pending keys into the sorted lists, then rebuild the offsets.
+ */
+void index::sync() {
+  if (P_.empty()) {
+    return;
+  }
+  size_t cardinality = cardinality_ + P_.size();
+  auto I = new block<entry>(dimensionality_, cardinality);
+  auto O = new block<OFFSET>(cardinality, dimensionality_ + 2);
+  std::vector<entry> pending(P_.size());
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    auto less = [&](const entry &x, const entry &y) {
+      auto vx = value(d, x);
+      auto vy = value(d, y);
+      return vx < vy || (vx == vy && x.key < y.key);
+    };
+    for (size_t i = 0; i < P_.size(); ++i) {
+      pending[i] = entry(P_[i], D_(P_[i], d));
+    }
+    std::sort(pending.begin(), pending.end(), less);
+    merge((*I_)(d), cardinality_, pending.data(), pending.size(), (*I)(d), less);
+    for (size_t i = 0; i < cardinality; ++i) {
+      (*O)((*I)(d, i).key, d) = (OFFSET) i;
+    }
+  }
+  delete I_;
+  delete O_;
+  if (map_) {
+    munmap(map_, mapped_);
+    map_ = nullptr;
+    mapped_ = 0;
+  }
+  I_ = I;
+  O_ = O;
+  cardinality_ = cardinality;
+  P_.clear();
+  thresholds_();
+  ranks_(1);
+  densify_(1);
+}
+
+/**
+ * Rank the values of each dimension from the sorted lists, tied values
+ * sharing a rank and ranks having no gaps, so that ranks compare as the
+ * values do. Ranks take 16 bits when no dimension has more than 2^16
+ * distinct values, 32 bits otherwise.
+ */
+void index::densify_(size_t threads) {
+  if (!dense_) {
+    return;
+  }
+  auto &I = *I_;
+  auto &O = *O_;
+  // The rank at each position of the sorted lists, dimension by dimension.
+  std::vector<unsigned int> at(cardinality_ * dimensionality_, 0);
+  parallel(threads, dimensionality_, [&](size_t first, size_t last) {
+    for (size_t d = first; d < last; ++d) {
+      auto rank = &at[d * cardinality_];
+      for (size_t i = 1; i < cardinality_; ++i) {
+        rank[i] = rank[i - 1] + (value(d, I(d, i - 1)) != value(d, I(d, i)));
+      }
+    }
+  });
+  unsigned int top = 0;
+  for (size_t d = 0; d < dimensionality_ && cardinality_; ++d) {
+    top = std::max(top, at[(d + 1) * cardinality_ - 1]);
+  }
+  bytes_ = top < 1 << 16 ? 2 : 4;
+  // The ranks of each row, written row by row.
+  R_.assign(cardinality_ * dimensionality_ * bytes_, 0);
+  parallel(threads, cardinality_, [&](size_t first, size_t last) {
+    for (size_t key = first; key < last; ++key) {
+      auto offsets = O(key);
+      for (size_t d = 0; d < dimensionality_; ++d) {
+        auto rank = at[d * cardinality_ + offsets[d]];
+        if (bytes_ == 2) {
+          ((unsigned short *) R_.data())[key * dimensionality_ + d] = (unsigned short) rank;
+        } else {
+          ((unsigned int *) R_.data())[key * dimensionality_ + d] = rank;
+        }
+      }
+    }
+  });
+  D_.ranks(R_.data(), bytes_);
+}
+
+/**
+ * Fill the max and mean ranks of each tuple from its offsets.
+ */
+void index::ranks_(size_t threads) {
+  auto &O = *O_;
+  parallel(threads, cardinality_, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      auto row = O(i);
+      auto &max = row[dimensionality_];
+      auto &mean = row[dimensionality_ + 1];
+      for (size_t d = 0; d < dimensionality_; ++d) {
+        if (max < row[d]) {
+          max = row[d];
+        }
+        mean += row[d];
+      }
+    }
+  });
+}
+
+auto index::signature_(K key) const -> unsigned long long {
+  unsigned long long signature = 0;
+  size_t bit = 0;
+  for (size_t d = 0; d < dimensionality_ && levels_; ++d) {
+    auto value = D_(key, d);
+    auto t = &T_[d * levels_];
+    for (size_t l = 0; l < levels_; ++l, ++bit) {
+      if (value > t[l]) {
+        signature |= 1ULL << bit;
+      }
+    }
+  }
+  return signature & bits_;
+}
+
+auto index::sum_(K key) const -> B {
+  if (!mask_) {
+    return D_.sum(key);
+  }
+  B sum = 0;
+  for (auto m = mask_; m; m &= m - 1) {
+    sum += D_(key, __builtin_ctzll(m));
+  }
+  return sum;
+}
+
+void index::thresholds_() {
+  // Quantiles of each dimension, read from the sorted lists.
+  auto &I = *I_;
+  T_.assign(dimensionality_ * levels_, 0);
+  for (size_t d = 0; d < dimensionality_ && cardinality_; ++d) {
+    for (size_t l = 0; l < levels_; ++l) {
+      T_[d * levels_ + l] = value(d, I(d, cardinality_ * (l + 1) / (levels_ + 1)));
+    }
+  }
+}
+
+/**
+ * The value of an entry of dimension d, read from the database when the
+ * index does not keep it.
+ */
+auto index::value(size_t d, const entry &e) const -> V {
+#ifndef WITHOUT_INDEX_VALUE
+  (void) d;
+  return e.value;
+#else
+  return D_(e.key, d);
+#endif
+}
+
 auto index::width() const -> size_t {
   return dimensionality_;
 }
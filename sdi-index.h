@@ -29,6 +29,7 @@
 #ifndef SDI_INDEX_H
 #define SDI_INDEX_H
 
+#include <vector>
 #include "sdi-block.h"
 #include "sdi-db.h"
 #include "sdi-entry.h"
@@ -38,26 +39,67 @@ namespace sdibench {
 class index {
 public:
   explicit index(db &);
+  explicit index(db &, const index &);
   virtual ~index();
   auto best() -> size_t;
-  void build();
+  void build(size_t);
+  void dense(bool);
+  void insert(K);
   auto dominate(size_t, K) -> bool;
+  auto dominators(size_t, K, size_t) -> size_t;
   void dump(std::ostream &);
+  static auto fits(size_t, size_t) -> bool;
   auto height() const -> size_t;
-  auto offsets(K) const -> size_t *;
+  auto load(const char *) -> bool;
+  auto memory() const -> size_t;
+  auto offsets(K) const -> OFFSET *;
+  auto pending() const -> size_t;
+  void region(K, std::vector<K> &);
+  void reset();
+  auto save(const char *) const -> bool;
   void skyline(size_t, K);
   void stop();
+  void subspace(MASK);
   auto stop(size_t) -> size_t;
+  void sync();
+  auto value(size_t, const entry &) const -> V;
   auto width() const -> size_t;
   auto operator()(size_t) -> entry *;
   auto operator()(size_t) const -> entry *;
 private:
+  /**
+   * A skyline tuple of a dimension, with its sum and its signature: one
+   * bit per threshold of each dimension, set when the value exceeds it. A
+   * tuple s can only dominate t if sum(s) <= sum(t) and the bits of s are
+   * a subset of those of t.
+   */
+  struct point {
+    B sum;
+    unsigned long long signature;
+    K key;
+  };
+  void densify_(size_t);
+  void ranks_(size_t);
+  auto signature_(K) const -> unsigned long long;
+  auto sum_(K) const -> B;
+  void thresholds_();
   db &D_; // The database D.
   block<entry> *I_; // The dimension index I.
-  block<size_t> *O_; // The offset list O.
-  block<V *> *S_; // The dimensional skyline S.
+  block<OFFSET> *O_; // The offset list O.
+  std::vector<point> *S_; // The dimensional skyline S, by increasing sums.
+  std::vector<V> T_; // The signature thresholds T, by dimension.
+  std::vector<K> P_; // The pending keys P, appended since the last sync.
+  std::vector<char> R_; // The dense ranks R by rows, when enabled.
+  size_t bytes_ = 0; // The size of a dense rank, 2 or 4 bytes.
+  bool dense_ = false;
+  bool owned_ = true; // False when the lists and offsets are another index's.
+  void *map_ = nullptr;
+  size_t mapped_ = 0;
   size_t cardinality_ = 0;
   size_t dimensionality_ = 0;
+  size_t levels_ = 0;
+  MASK mask_ = 0; // The dimensions of the query, 0 for all of them.
+  unsigned long long bits_ = ~0ULL; // The signature bits of these dimensions.
   size_t *skyline_ = nullptr;
   bool *stop_ = nullptr;
 };
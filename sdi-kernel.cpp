@@ -0,0 +1,766 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "sdi-kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SDI_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// The kernels of any width are written for doubles; other values get the
+// scalar ones, and those of a fixed width.
+#if defined(SDI_KERNEL_X86) && !defined(WITH_FLOAT) && !defined(WITH_QUANTIZED)
+#define SDI_KERNEL_DOUBLE
+#endif
+
+namespace sdibench {
+
+static auto scalar(const V *p1, const V *p2, size_t width) -> bool {
+  bool dominating = false;
+  for (size_t i = 0; i < width; ++i, ++p1, ++p2) {
+    if (*p1 > *p2) {
+      return false;
+    } else if (*p1 < *p2 && !dominating) {
+      dominating = true;
+    }
+  }
+  return dominating;
+}
+
+static auto scan_scalar(const view &v, const K *rows, size_t n, size_t t, size_t &dte, size_t &dt) -> bool {
+  auto p2 = v.data + t * v.pitch;
+  auto min = v.bounds[2 * t];
+  auto sum = v.bounds[2 * t + 1];
+  for (size_t i = 0; i < n; ++i) {
+    ++dte;
+    auto bs = v.bounds + 2 * rows[i];
+    if (!(bs[0] <= min && bs[1] <= sum)) {
+      continue;
+    }
+    ++dt;
+    auto p1 = v.data + rows[i] * v.pitch;
+    bool worse = false;
+    bool dominating = false;
+    for (size_t d = 0; d < v.width && !worse; ++d) {
+      auto a = p1[d * v.stride];
+      auto b = p2[d * v.stride];
+      worse = a > b;
+      dominating = dominating || a < b;
+    }
+    if (!worse && dominating) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * The scalar kernel for rows of _D values: all values are compared without
+ * branches, which the compiler unrolls and vectorises.
+ */
+template<size_t _D>
+static auto fixed(const V *p1, const V *p2, size_t) -> bool {
+  bool worse = false;
+  bool dominating = false;
+  for (size_t i = 0; i < _D; ++i) {
+    worse |= p1[i] > p2[i];
+    dominating |= p1[i] < p2[i];
+  }
+  return !worse && dominating;
+}
+
+/**
+ * A scan of rows of _D adjacent values, the row t being tested against
+ * each of them by the inlined fixed kernel.
+ */
+template<size_t _D>
+static auto scan_fixed(const view &v, const K *rows, size_t n, size_t t, size_t &dte, size_t &dt) -> bool {
+  auto p2 = v.data + t * v.pitch;
+  auto min = v.bounds[2 * t];
+  auto sum = v.bounds[2 * t + 1];
+  size_t compared = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto bs = v.bounds + 2 * rows[i];
+    if (!(bs[0] <= min && bs[1] <= sum)) {
+      continue;
+    }
+    ++compared;
+    if (fixed<_D>(v.data + rows[i] * v.pitch, p2, _D)) {
+      dte += i + 1;
+      dt += compared;
+      return true;
+    }
+  }
+  dte += n;
+  dt += compared;
+  return false;
+}
+
+/**
+ * The scalar rank kernel for rows of any width, ranks being of type _R.
+ */
+template<class _R>
+static auto ranks(const void *r1, const void *r2, size_t width) -> bool {
+  auto p1 = (const _R *) r1;
+  auto p2 = (const _R *) r2;
+  bool worse = false;
+  bool dominating = false;
+  for (size_t i = 0; i < width; ++i) {
+    worse |= p1[i] > p2[i];
+    dominating |= p1[i] < p2[i];
+  }
+  return !worse && dominating;
+}
+
+/**
+ * The scalar rank kernel for rows of _D ranks.
+ */
+template<class _R, size_t _D>
+static auto fixed_ranks(const void *r1, const void *r2, size_t) -> bool {
+  return ranks<_R>(r1, r2, _D);
+}
+
+/**
+ * A scan of dense ranks of type _R, the rows being tested by the rank
+ * kernel k, inlined.
+ */
+template<class _R, bool (*_K)(const void *, const void *, size_t)>
+static auto scan_ranks(const dense &r, const K *rows, size_t n, size_t t, size_t &dte, size_t &dt) -> bool {
+  auto p2 = (const _R *) r.ranks + t * r.width;
+  auto min = r.bounds[2 * t];
+  auto sum = r.bounds[2 * t + 1];
+  size_t compared = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto bs = r.bounds + 2 * rows[i];
+    if (!(bs[0] <= min && bs[1] <= sum)) {
+      continue;
+    }
+    ++compared;
+    if (_K((const _R *) r.ranks + rows[i] * r.width, p2, r.width)) {
+      dte += i + 1;
+      dt += compared;
+      return true;
+    }
+  }
+  dte += n;
+  dt += compared;
+  return false;
+}
+
+#ifdef SDI_KERNEL_DOUBLE
+
+// The comparisons are ordered and quiet, so that a NaN is neither worse nor
+// better, as in the scalar kernel.
+
+__attribute__((target("sse2")))
+static auto sse2(const V *p1, const V *p2, size_t width) -> bool {
+  size_t i = 0;
+  __m128d lt = _mm_setzero_pd();
+  for (; i + 2 <= width; i += 2) {
+    __m128d a = _mm_loadu_pd(p1 + i);
+    __m128d b = _mm_loadu_pd(p2 + i);
+    if (_mm_movemask_pd(_mm_cmpgt_pd(a, b))) {
+      return false;
+    }
+    lt = _mm_or_pd(lt, _mm_cmplt_pd(a, b));
+  }
+  bool dominating = _mm_movemask_pd(lt) != 0;
+  if (i < width) {
+    if (p1[i] > p2[i]) {
+      return false;
+    } else if (p1[i] < p2[i]) {
+      dominating = true;
+    }
+  }
+  return dominating;
+}
+
+__attribute__((target("avx2")))
+static auto avx2(const V *p1, const V *p2, size_t width) -> bool {
+  size_t i = 0;
+  __m256d lt = _mm256_setzero_pd();
+  for (; i + 4 <= width; i += 4) {
+    __m256d a = _mm256_loadu_pd(p1 + i);
+    __m256d b = _mm256_loadu_pd(p2 + i);
+    if (_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ))) {
+      return false;
+    }
+    lt = _mm256_or_pd(lt, _mm256_cmp_pd(a, b, _CMP_LT_OQ));
+  }
+  bool dominating = _mm256_movemask_pd(lt) != 0;
+  if (i + 2 <= width) {
+    __m128d a = _mm_loadu_pd(p1 + i);
+    __m128d b = _mm_loadu_pd(p2 + i);
+    if (_mm_movemask_pd(_mm_cmpgt_pd(a, b))) {
+      return false;
+    }
+    dominating = dominating || _mm_movemask_pd(_mm_cmplt_pd(a, b));
+    i += 2;
+  }
+  if (i < width) {
+    if (p1[i] > p2[i]) {
+      return false;
+    } else if (p1[i] < p2[i]) {
+      dominating = true;
+    }
+  }
+  return dominating;
+}
+
+__attribute__((target("avx512f")))
+static auto avx512(const V *p1, const V *p2, size_t width) -> bool {
+  __mmask8 lt = 0;
+  for (size_t i = 0; i < width; i += 8) {
+    __mmask8 m = width - i >= 8 ? (__mmask8) 0xff : (__mmask8) ((1U << (width - i)) - 1);
+    __m512d a = _mm512_maskz_loadu_pd(m, p1 + i);
+    __m512d b = _mm512_maskz_loadu_pd(m, p2 + i);
+    if (_mm512_mask_cmp_pd_mask(m, a, b, _CMP_GT_OQ)) {
+      return false;
+    }
+    lt |= _mm512_mask_cmp_pd_mask(m, a, b, _CMP_LT_OQ);
+  }
+  return lt != 0;
+}
+
+/**
+ * Test t against 8 rows at once: each dimension of the 8 rows is gathered
+ * into one register and compared with the broadcast value of t. With the
+ * column layout, this reads one value per column and per row only.
+ */
+__attribute__((target("avx512f,avx512dq")))
+static auto scan_avx512(const view &v, const K *rows, size_t n, size_t t, size_t &dte, size_t &dt) -> bool {
+  auto p2 = v.data + t * v.pitch;
+  __m512d min = _mm512_set1_pd(v.bounds[2 * t]);
+  __m512d sum = _mm512_set1_pd(v.bounds[2 * t + 1]);
+  __m512i pitch = _mm512_set1_epi64((long long) v.pitch);
+  __m512i two = _mm512_set1_epi64(2);
+  for (size_t i = 0; i < n; i += 8) {
+    __mmask8 m = n - i >= 8 ? (__mmask8) 0xff : (__mmask8) ((1U << (n - i)) - 1);
+    __m512i keys;
+    if (sizeof(K) == sizeof(unsigned int)) {
+      __m512i k32 = _mm512_maskz_loadu_epi32((__mmask16) m, rows + i);
+      keys = _mm512_cvtepu32_epi64(_mm512_castsi512_si256(k32));
+    } else {
+      keys = _mm512_maskz_loadu_epi64(m, rows + i);
+    }
+    __m512i b = _mm512_mullo_epi64(keys, two);
+    __m512d smin = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), m, b, v.bounds, 8);
+    __m512d ssum = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), m, b, v.bounds + 1, 8);
+    __mmask8 comparable = _mm512_mask_cmp_pd_mask(m, smin, min, _CMP_LE_OQ);
+    comparable = _mm512_mask_cmp_pd_mask(comparable, ssum, sum, _CMP_LE_OQ);
+    __mmask8 worse = 0;
+    __mmask8 better = 0;
+    __m512i offsets = _mm512_mullo_epi64(keys, pitch);
+    for (size_t d = 0; d < v.width && (comparable & ~worse); ++d) {
+      __m512d s = _mm512_mask_i64gather_pd(_mm512_setzero_pd(), comparable & ~worse, offsets,
+                                           v.data + d * v.stride, 8);
+      __m512d x = _mm512_set1_pd(p2[d * v.stride]);
+      worse |= _mm512_mask_cmp_pd_mask(comparable & ~worse, s, x, _CMP_GT_OQ);
+      better |= _mm512_mask_cmp_pd_mask(comparable & ~worse, s, x, _CMP_LT_OQ);
+    }
+    __mmask8 dominating = comparable & ~worse & better;
+    if (dominating) {
+      // Count as if the rows were tested one by one up to the first hit.
+      unsigned first = __builtin_ctz(dominating);
+      dte += first + 1;
+      dt += __builtin_popcount(comparable & ((2U << first) - 1));
+      return true;
+    }
+    dte += __builtin_popcount(m);
+    dt += __builtin_popcount(comparable);
+  }
+  return false;
+}
+
+#endif
+
+#ifdef SDI_KERNEL_X86
+
+/**
+ * The AVX-512 operations on values or dense ranks of type _T: 8 doubles, 16
+ * floats or 32-bit ranks, or 32 16-bit values or ranks per register. The
+ * comparisons of floating values are ordered and quiet.
+ */
+template<class _T>
+struct lanes;
+
+template<>
+struct lanes<double> {
+  static const size_t width = 8;
+  __attribute__((target("avx512f,avx512bw")))
+  static auto head(size_t n) -> __mmask8 {
+    return n >= 8 ? (__mmask8) 0xff : (__mmask8) ((1U << n) - 1);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto load(__mmask8 m, const double *p) -> __m512d {
+    return _mm512_maskz_loadu_pd(m, p);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto gt(__mmask8 m, __m512d a, __m512d b) -> __mmask8 {
+    return _mm512_mask_cmp_pd_mask(m, a, b, _CMP_GT_OQ);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto lt(__mmask8 m, __m512d a, __m512d b) -> __mmask8 {
+    return _mm512_mask_cmp_pd_mask(m, a, b, _CMP_LT_OQ);
+  }
+};
+
+template<>
+struct lanes<float> {
+  static const size_t width = 16;
+  __attribute__((target("avx512f,avx512bw")))
+  static auto head(size_t n) -> __mmask16 {
+    return n >= 16 ? (__mmask16) 0xffff : (__mmask16) ((1U << n) - 1);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto load(__mmask16 m, const float *p) -> __m512 {
+    return _mm512_maskz_loadu_ps(m, p);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto gt(__mmask16 m, __m512 a, __m512 b) -> __mmask16 {
+    return _mm512_mask_cmp_ps_mask(m, a, b, _CMP_GT_OQ);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto lt(__mmask16 m, __m512 a, __m512 b) -> __mmask16 {
+    return _mm512_mask_cmp_ps_mask(m, a, b, _CMP_LT_OQ);
+  }
+};
+
+template<>
+struct lanes<unsigned short> {
+  static const size_t width = 32;
+  __attribute__((target("avx512f,avx512bw")))
+  static auto head(size_t n) -> __mmask32 {
+    return n >= 32 ? ~(__mmask32) 0 : (__mmask32) ((1U << n) - 1);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto load(__mmask32 m, const unsigned short *p) -> __m512i {
+    return _mm512_maskz_loadu_epi16(m, p);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto gt(__mmask32 m, __m512i a, __m512i b) -> __mmask32 {
+    return _mm512_mask_cmpgt_epu16_mask(m, a, b);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto lt(__mmask32 m, __m512i a, __m512i b) -> __mmask32 {
+    return _mm512_mask_cmplt_epu16_mask(m, a, b);
+  }
+};
+
+template<>
+struct lanes<unsigned int> {
+  static const size_t width = 16;
+  __attribute__((target("avx512f,avx512bw")))
+  static auto head(size_t n) -> __mmask16 {
+    return n >= 16 ? (__mmask16) 0xffff : (__mmask16) ((1U << n) - 1);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto load(__mmask16 m, const unsigned int *p) -> __m512i {
+    return _mm512_maskz_loadu_epi32(m, p);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto gt(__mmask16 m, __m512i a, __m512i b) -> __mmask16 {
+    return _mm512_mask_cmpgt_epu32_mask(m, a, b);
+  }
+  __attribute__((target("avx512f,avx512bw")))
+  static auto lt(__mmask16 m, __m512i a, __m512i b) -> __mmask16 {
+    return _mm512_mask_cmplt_epu32_mask(m, a, b);
+  }
+};
+
+/**
+ * The AVX-512 kernel for rows of _D values or ranks of type _T, the masks of
+ * the loads being known at compile time.
+ */
+template<class _T, size_t _D>
+__attribute__((target("avx512f,avx512bw")))
+static auto avx512_lanes(const void *r1, const void *r2, size_t) -> bool {
+  typedef lanes<_T> L;
+  decltype(L::head(0)) gt = 0;
+  decltype(L::head(0)) lt = 0;
+  for (size_t i = 0; i < _D; i += L::width) {
+    auto m = L::head(_D - i);
+    auto a = L::load(m, (const _T *) r1 + i);
+    auto b = L::load(m, (const _T *) r2 + i);
+    gt |= L::gt(m, a, b);
+    lt |= L::lt(m, a, b);
+  }
+  return !gt && lt;
+}
+
+/**
+ * A scan of rows of _D values or ranks of type _T, pitch apart, the row t
+ * being loaded into registers once.
+ */
+template<class _T, size_t _D>
+__attribute__((target("avx512f,avx512bw")))
+static auto scan_avx512_lanes(const _T *data, const B *bounds, size_t pitch, const K *rows, size_t n, size_t t,
+                              size_t &dte, size_t &dt) -> bool {
+  typedef lanes<_T> L;
+  const size_t chunks = (_D + L::width - 1) / L::width;
+  auto p2 = data + t * pitch;
+  auto min = bounds[2 * t];
+  auto sum = bounds[2 * t + 1];
+  decltype(L::load(0, p2)) b[chunks];
+  for (size_t c = 0; c < chunks; ++c) {
+    b[c] = L::load(L::head(_D - c * L::width), p2 + c * L::width);
+  }
+  size_t compared = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto bs = bounds + 2 * rows[i];
+    if (!(bs[0] <= min && bs[1] <= sum)) {
+      continue;
+    }
+    ++compared;
+    auto p1 = data + rows[i] * pitch;
+    decltype(L::head(0)) gt = 0;
+    decltype(L::head(0)) lt = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+      auto m = L::head(_D - c * L::width);
+      auto a = L::load(m, p1 + c * L::width);
+      gt |= L::gt(m, a, b[c]);
+      lt |= L::lt(m, a, b[c]);
+    }
+    if (!gt && lt) {
+      dte += i + 1;
+      dt += compared;
+      return true;
+    }
+  }
+  dte += n;
+  dt += compared;
+  return false;
+}
+
+/**
+ * The AVX-512 kernel for rows of _D values.
+ */
+template<size_t _D>
+__attribute__((target("avx512f,avx512bw")))
+static auto avx512_fixed(const V *p1, const V *p2, size_t) -> bool {
+  return avx512_lanes<V, _D>(p1, p2, _D);
+}
+
+/**
+ * As scan_fixed(), the row t being loaded into registers once.
+ */
+template<size_t _D>
+__attribute__((target("avx512f,avx512bw")))
+static auto scan_avx512_fixed(const view &v, const K *rows, size_t n, size_t t, size_t &dte, size_t &dt) -> bool {
+  return scan_avx512_lanes<V, _D>(v.data, v.bounds, v.pitch, rows, n, t, dte, dt);
+}
+
+/**
+ * As scan_avx512_fixed(), on dense ranks of type _R.
+ */
+template<class _R, size_t _D>
+__attribute__((target("avx512f,avx512bw")))
+static auto scan_avx512_ranks(const dense &r, const K *rows, size_t n, size_t t, size_t &dte, size_t &dt) -> bool {
+  return scan_avx512_lanes<_R, _D>((const _R *) r.ranks, r.bounds, _D, rows, n, t, dte, dt);
+}
+
+#endif
+
+/**
+ * The kernels of a fixed width, from _D down to 2, found by recursion over
+ * the instantiations; other widths get no kernel, or the scalar one for
+ * dense ranks.
+ */
+template<size_t _D>
+struct widths {
+  static auto kernel_for(size_t width, bool avx512) -> kernel {
+    if (width != _D) {
+      return widths<_D - 1>::kernel_for(width, avx512);
+    }
+#ifdef SDI_KERNEL_X86
+    if (avx512) {
+      return avx512_fixed<_D>;
+    }
+#endif
+    return fixed<_D>;
+  }
+  static auto scan_for(size_t width, bool avx512) -> scan {
+    if (width != _D) {
+      return widths<_D - 1>::scan_for(width, avx512);
+    }
+#ifdef SDI_KERNEL_X86
+    if (avx512) {
+      return scan_avx512_fixed<_D>;
+    }
+#endif
+    return scan_fixed<_D>;
+  }
+  template<class _R>
+  static auto rank_kernel_for(size_t width, bool avx512) -> rank_kernel {
+    if (width != _D) {
+      return widths<_D - 1>::template rank_kernel_for<_R>(width, avx512);
+    }
+#ifdef SDI_KERNEL_X86
+    if (avx512) {
+      return avx512_lanes<_R, _D>;
+    }
+#endif
+    return fixed_ranks<_R, _D>;
+  }
+  template<class _R>
+  static auto rank_scan_for(size_t width, bool avx512) -> rank_scan {
+    if (width != _D) {
+      return widths<_D - 1>::template rank_scan_for<_R>(width, avx512);
+    }
+#ifdef SDI_KERNEL_X86
+    if (avx512) {
+      return scan_avx512_ranks<_R, _D>;
+    }
+#endif
+    return scan_ranks<_R, fixed_ranks<_R, _D>>;
+  }
+};
+
+template<>
+struct widths<1> {
+  static auto kernel_for(size_t, bool) -> kernel {
+    return nullptr;
+  }
+  static auto scan_for(size_t, bool) -> scan {
+    return nullptr;
+  }
+  template<class _R>
+  static auto rank_kernel_for(size_t, bool) -> rank_kernel {
+    return ranks<_R>;
+  }
+  template<class _R>
+  static auto rank_scan_for(size_t, bool) -> rank_scan {
+    return scan_ranks<_R, ranks<_R>>;
+  }
+};
+
+static auto avx512_supported() -> bool {
+#ifdef SDI_KERNEL_X86
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#else
+  return false;
+#endif
+}
+
+static auto any_supported() -> bool {
+  return true;
+}
+
+#ifdef SDI_KERNEL_DOUBLE
+static auto avx512f_supported() -> bool {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f");
+}
+
+static auto avx512dq_supported() -> bool {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+}
+
+static auto avx2_supported() -> bool {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+static auto sse2_supported() -> bool {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2");
+}
+#endif
+
+static const struct {
+  const char *name;
+  kernel k;
+  bool (*supported)();
+} kernels[] = {
+#ifdef SDI_KERNEL_DOUBLE
+    {"avx512", avx512, avx512f_supported},
+    {"avx2", avx2, avx2_supported},
+    {"sse2", sse2, sse2_supported},
+#endif
+    {"scalar", scalar, any_supported}
+};
+
+/**
+ * The kernel of the given name, or nullptr if there is none or if the CPU
+ * cannot run it.
+ */
+auto kernel_by_name(const char *name) -> kernel {
+  for (auto &&x : kernels) {
+    if (!strcmp(x.name, name)) {
+      return x.supported() ? x.k : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+auto kernel_name(kernel k) -> const char * {
+  for (auto &&x : kernels) {
+    if (x.k == k) {
+      return x.name;
+    }
+  }
+  return "unknown";
+}
+
+static const struct {
+  const char *name;
+  scan s;
+  bool (*supported)();
+} scans[] = {
+#ifdef SDI_KERNEL_DOUBLE
+    {"avx512", scan_avx512, avx512dq_supported},
+#endif
+    {"scalar", scan_scalar, any_supported}
+};
+
+/**
+ * As kernel_by_name(), for scans.
+ */
+auto scan_by_name(const char *name) -> scan {
+  for (auto &&x : scans) {
+    if (!strcmp(x.name, name)) {
+      return x.supported() ? x.s : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * The kernel name SDI_KERNEL forces, e.g. to compare against the scalar
+ * one, or nullptr. A kernel the CPU cannot run is reported once, and the
+ * kernels are then selected as if none was forced.
+ */
+static auto forced() -> const char * {
+  static const char *name = [] {
+    auto name = getenv("SDI_KERNEL");
+    for (auto &&x : kernels) {
+      if (name && !strcmp(x.name, name) && !x.supported()) {
+        std::cerr << "- kernel not supported by this CPU. " << name << std::endl;
+        return (const char *) nullptr;
+      }
+    }
+    return (const char *) name;
+  }();
+  return name;
+}
+
+/**
+ * Whether rank kernels may use AVX-512: rank kernels have no SSE2 or AVX2
+ * version, so a kernel forced by SDI_KERNEL other than avx512 selects the
+ * scalar ones of a fixed width.
+ */
+static auto avx512_ranks_supported() -> bool {
+  auto name = forced();
+  if (name && kernel_by_name(name)) {
+    return !strcmp(name, "avx512") && avx512_supported();
+  }
+  return avx512_supported();
+}
+
+auto scan_select() -> scan {
+  auto name = forced();
+  if (name && scan_by_name(name)) {
+    return scan_by_name(name);
+  }
+#ifdef SDI_KERNEL_DOUBLE
+  if (avx512dq_supported()) {
+    return scan_avx512;
+  }
+#endif
+  return scan_scalar;
+}
+
+auto kernel_select() -> kernel {
+  auto name = forced();
+  if (name && kernel_by_name(name)) {
+    return kernel_by_name(name);
+  }
+#ifdef SDI_KERNEL_DOUBLE
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return sse2;
+  }
+#endif
+  return scalar;
+}
+
+/**
+ * The kernel of a fixed width for rows of width values, or the selected
+ * one for other widths or when SDI_KERNEL forces a kernel.
+ */
+auto kernel_select(size_t width) -> kernel {
+  auto name = forced();
+  auto k = name && kernel_by_name(name) ? nullptr : widths<SDI_KERNEL_DIMS>::kernel_for(width, avx512_supported());
+  return k ? k : kernel_select();
+}
+
+/**
+ * The scan of a fixed width for rows of width adjacent values, or nullptr
+ * for other widths or when SDI_KERNEL forces a kernel.
+ */
+auto scan_select(size_t width) -> scan {
+  auto name = forced();
+  return name && kernel_by_name(name) ? nullptr : widths<SDI_KERNEL_DIMS>::scan_for(width, avx512_supported());
+}
+
+/**
+ * The rank kernel for rows of width dense ranks of the given size in bytes,
+ * 2 or 4.
+ */
+auto rank_kernel_select(size_t bytes, size_t width) -> rank_kernel {
+  auto avx512 = avx512_ranks_supported();
+  if (bytes == 2) {
+    return widths<SDI_KERNEL_DIMS>::rank_kernel_for<unsigned short>(width, avx512);
+  }
+  return widths<SDI_KERNEL_DIMS>::rank_kernel_for<unsigned int>(width, avx512);
+}
+
+/**
+ * As rank_kernel_select(), for scans.
+ */
+auto rank_scan_select(size_t bytes, size_t width) -> rank_scan {
+  auto avx512 = avx512_ranks_supported();
+  if (bytes == 2) {
+    return widths<SDI_KERNEL_DIMS>::rank_scan_for<unsigned short>(width, avx512);
+  }
+  return widths<SDI_KERNEL_DIMS>::rank_scan_for<unsigned int>(width, avx512);
+}
+
+}
@@ -0,0 +1,100 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef SDI_KERNEL_H
+#define SDI_KERNEL_H
+
+#include "sdi-types.h"
+
+// Rows of 2 to SDI_KERNEL_DIMS values get kernels of a fixed width, with
+// their loops unrolled at compile time.
+#ifndef SDI_KERNEL_DIMS
+#define SDI_KERNEL_DIMS 16
+#endif
+
+namespace sdibench {
+
+/**
+ * A dominance kernel returns true if the row p1 is no worse than the row
+ * p2 in all of the width values and strictly better in at least one.
+ */
+typedef bool (*kernel)(const V *, const V *, size_t);
+
+/**
+ * The values seen by a scan kernel: value d of row r is at
+ * data[r * pitch + d * stride], its min and sum at bounds[2 * r] and
+ * bounds[2 * r + 1].
+ */
+struct view {
+  const V *data;
+  const B *bounds;
+  size_t pitch;
+  size_t stride;
+  size_t width;
+};
+
+/**
+ * A scan kernel returns true if one of the n rows dominates the row t. It
+ * tests the rows in order, skips those whose bounds are incomparable with
+ * t, stops at the first dominating one, and adds the number of rows looked
+ * at to dte and the number of rows compared to dt.
+ */
+typedef bool (*scan)(const view &, const K *, size_t, size_t, size_t &, size_t &);
+
+/**
+ * The dense ranks seen by a rank scan: rank d of row r is at
+ * ranks[r * width + d], tied values sharing a rank, and its bounds are as
+ * in a view.
+ */
+struct dense {
+  const void *ranks;
+  const B *bounds;
+  size_t width;
+};
+
+/**
+ * Rank kernels and rank scans do as dominance kernels and scan kernels, on
+ * the dense ranks of the rows instead of their values; ranks are of the
+ * size they were selected for.
+ */
+typedef bool (*rank_kernel)(const void *, const void *, size_t);
+typedef bool (*rank_scan)(const dense &, const K *, size_t, size_t, size_t &, size_t &);
+
+auto kernel_by_name(const char *) -> kernel;
+auto kernel_name(kernel) -> const char *;
+auto kernel_select() -> kernel;
+auto kernel_select(size_t) -> kernel;
+auto rank_kernel_select(size_t, size_t) -> rank_kernel;
+auto rank_scan_select(size_t, size_t) -> rank_scan;
+auto scan_by_name(const char *) -> scan;
+auto scan_select() -> scan;
+auto scan_select(size_t) -> scan;
+
+}
+
+#endif //SDI_KERNEL_H
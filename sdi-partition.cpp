@@ -0,0 +1,168 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <atomic>
+#include <mutex>
+#include "parallel.h"
+#include "sdi-entry.h"
+#include "sdi-partition.h"
+
+// Bytes of data and index per partition, sized for the last level cache.
+#ifndef SDI_PARTITION_CACHE
+#define SDI_PARTITION_CACHE (8 << 20)
+#endif
+
+namespace sdibench {
+
+partition::partition(size_t cardinality, size_t dimensionality) : partition(cardinality, dimensionality,
+                                                                            layout::row) {
+}
+
+partition::partition(size_t cardinality, size_t dimensionality, layout layout) : D_(cardinality, dimensionality,
+                                                                                    layout) {
+  cardinality_ = cardinality;
+  dimensionality_ = dimensionality;
+}
+
+void partition::build(const generator &generator) {
+  generator.generate(D_, threads_);
+}
+
+void partition::build(std::istream &in) {
+  in >> D_;
+}
+
+auto partition::build(const char *filename) -> bool {
+  return D_.load(filename, threads_);
+}
+
+/**
+ * The number of local skyline tuples merged by the last query.
+ */
+auto partition::candidates() const -> size_t {
+  return candidates_;
+}
+
+auto partition::memory() const -> size_t {
+  return D_.memory() + S_.capacity() * sizeof(K);
+}
+
+/**
+ * Whether only a prefix of a binary dataset was loaded, see db::partial().
+ */
+auto partition::partial() const -> bool {
+  return D_.partial();
+}
+
+/**
+ * The number of partitions: as set, or enough for each partition to fit
+ * SDI_PARTITION_CACHE bytes, and at least one per thread.
+ */
+auto partition::partitions() const -> size_t {
+  size_t partitions = partitions_;
+  if (!partitions) {
+    size_t tuple = dimensionality_ * (sizeof(V) + sizeof(entry)) + (dimensionality_ + 2) * sizeof(OFFSET);
+    partitions = (cardinality_ * tuple + SDI_PARTITION_CACHE - 1) / SDI_PARTITION_CACHE;
+    partitions = partitions > threads_ ? partitions : threads_;
+  }
+  if (partitions > cardinality_) {
+    partitions = cardinality_;
+  }
+  return partitions > 0 ? partitions : 1;
+}
+
+void partition::partitions(size_t partitions) {
+  partitions_ = partitions;
+}
+
+void partition::query() {
+  size_t partitions = this->partitions();
+  size_t workers = threads_ < partitions ? threads_ : partitions;
+  std::vector<std::vector<K>> local(partitions);
+  std::atomic<size_t> next(0);
+  std::mutex lock;
+  stats::scope scope(stats_);
+  stats counts;
+  // Local skyline tuples are only candidates, they are not counted.
+  size_t sky = stats::local().SKY;
+  parallel(workers, [&](size_t t) {
+    for (size_t p = next++; p < partitions; p = next++) {
+      size_t first = cardinality_ * p / partitions;
+      size_t last = cardinality_ * (p + 1) / partitions;
+      sdi method(D_, first, last);
+      method.build();
+      method.query();
+      for (auto &&k : method.skyline()) {
+        local[p].push_back(first + k);
+      }
+    }
+    if (t) {
+      auto shard = stats::take();
+      std::lock_guard<std::mutex> guard(lock);
+      counts += shard;
+    }
+  });
+  counts.SKY = 0;
+  stats::local() += counts;
+  stats::local().SKY = sky;
+  std::vector<K> rows;
+  for (auto &&l : local) {
+    rows.insert(rows.end(), l.begin(), l.end());
+  }
+  candidates_ = rows.size();
+  sdi merge(D_, rows);
+  merge.threads(threads_);
+  merge.build();
+  merge.query();
+  S_.clear();
+  for (auto &&k : merge.skyline()) {
+    S_.push_back(rows[k]);
+  }
+}
+
+auto partition::skyline() const -> const std::vector<K> & {
+  return S_;
+}
+
+auto partition::statistics() const -> const stats & {
+  return stats_;
+}
+
+auto partition::threads() const -> size_t {
+  return threads_;
+}
+
+void partition::threads(size_t threads) {
+  threads_ = threads > 0 ? threads : 1;
+}
+
+auto partition::verify() const -> bool {
+  return D_.verify();
+}
+
+}
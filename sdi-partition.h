@@ -0,0 +1,76 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef SDI_PARTITION_H
+#define SDI_PARTITION_H
+
+#include <istream>
+#include <vector>
+#include "sdi-db.h"
+#include "sdi.h"
+
+namespace sdibench {
+
+/**
+ * Partition-and-merge skyline: rows are split into partitions, each one
+ * queried by its own sdi method on a view of the database, then the union
+ * of the local skylines is queried once more to drop the tuples dominated
+ * across partitions.
+ */
+class partition {
+public:
+  explicit partition(size_t, size_t);
+  explicit partition(size_t, size_t, layout);
+  void build(const generator &);
+  void build(std::istream &);
+  auto build(const char *) -> bool;
+  auto candidates() const -> size_t;
+  auto memory() const -> size_t;
+  auto partial() const -> bool;
+  auto partitions() const -> size_t;
+  void partitions(size_t);
+  void query();
+  auto skyline() const -> const std::vector<K> &;
+  auto statistics() const -> const stats &;
+  auto threads() const -> size_t;
+  void threads(size_t);
+  auto verify() const -> bool;
+private:
+  db D_;
+  std::vector<K> S_;
+  stats stats_; // The counts of the last query.
+  size_t candidates_ = 0;
+  size_t cardinality_ = 0;
+  size_t dimensionality_ = 0;
+  size_t partitions_ = 0;
+  size_t threads_ = 1;
+};
+
+}
+
+#endif //SDI_PARTITION_H
@@ -0,0 +1,314 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include "parallel.h"
+#include "sdi-skycube.h"
+
+namespace sdibench {
+
+skycube::skycube(size_t cardinality, size_t dimensionality) : skycube(cardinality, dimensionality, layout::row) {
+}
+
+skycube::skycube(size_t cardinality, size_t dimensionality, layout layout) : method_(cardinality, dimensionality,
+                                                                                    layout) {
+  dimensionality_ = dimensionality;
+}
+
+void skycube::build(const generator &generator) {
+  method_.threads(threads_);
+  method_.build(generator);
+}
+
+void skycube::build(std::istream &in) {
+  method_.threads(threads_);
+  method_.build(in);
+}
+
+auto skycube::build(const char *filename) -> bool {
+  method_.threads(threads_);
+  return method_.build(filename);
+}
+
+/**
+ * Whether the tuple key is in the skyline of the subspace mask.
+ */
+auto skycube::contains(K key, MASK mask) const -> bool {
+  auto at = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (at == keys_.end() || *at != key) {
+    return false;
+  }
+  return membership_[(size_t) (at - keys_.begin()) << dimensionality_ | mask];
+}
+
+auto skycube::memory() const -> size_t {
+  return method_.memory() + keys_.capacity() * sizeof(K) + membership_.size() / 8 +
+         sizes_.capacity() * sizeof(size_t);
+}
+
+auto skycube::partial() const -> bool {
+  return method_.partial();
+}
+
+void skycube::query() {
+  stats::scope scope(stats_);
+  auto &D = method_.data();
+  size_t d = dimensionality_;
+  MASK all = (1ULL << d) - 1;
+  method_.query();
+  // Tuples sharing a value with another one in a dimension, found next to
+  // each other in the sorted lists of the index. A dominated tuple without
+  // ties is strictly dominated, thus out of the extended skyline.
+  auto &I = method_.I_;
+  std::vector<MASK> ties(D.height(), 0);
+  for (size_t j = 0; j < d; ++j) {
+    auto list = I(j);
+    for (size_t i = 1; i < I.height(); ++i) {
+      if (I.value(j, list[i - 1]) == I.value(j, list[i])) {
+        ties[list[i - 1].key] |= 1ULL << j;
+        ties[list[i].key] |= 1ULL << j;
+      }
+    }
+  }
+  // Extended skyline of the whole space: tuples strictly dominated in all
+  // dimensions are strictly dominated by a skyline tuple.
+  auto &skyline = method_.skyline();
+  lists sorted;
+  sort_(D, skyline, all, sorted);
+  std::vector<std::vector<K>> found(threads_);
+  parallel(threads_, [&](size_t w) {
+    auto &f = found[w];
+    for (size_t t = D.height() * w / threads_; t < D.height() * (w + 1) / threads_; ++t) {
+      if (!ties[t] || D.erased(t) || D.skyline(t)) {
+        continue;
+      }
+      if (!strict_(D, all, sorted, t)) {
+        f.push_back(t);
+      }
+    }
+  });
+  keys_ = skyline;
+  for (auto &&f : found) {
+    keys_.insert(keys_.end(), f.begin(), f.end());
+  }
+  std::sort(keys_.begin(), keys_.end());
+  size_t n = keys_.size();
+  membership_.resize(n << d);
+  membership_.clear();
+  sizes_.assign(all + 1, 0);
+  // Extended skylines of the current and the parent level, by subspace,
+  // as rows of the extended skyline of the whole space.
+  std::vector<std::vector<K>> extended(all + 1);
+  extended[all].resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    extended[all][i] = i;
+    if (D.skyline(keys_[i])) {
+      membership_.set(i << d | all);
+      ++sizes_[all];
+    }
+  }
+  // Workers share one index of the extended skyline, each one with its
+  // own flags and query state.
+  size_t workers = threads_ < d ? threads_ : d;
+  sdi shared(D, keys_);
+  shared.threads(threads_);
+  shared.build();
+  std::vector<sdi *> local(workers, nullptr);
+  for (size_t w = 0; w < workers; ++w) {
+    local[w] = new sdi(shared.D_, shared.I_);
+  }
+  // Counters of the workers, the skyline count staying the one of the
+  // whole space.
+  stats counts;
+  std::mutex lock;
+  auto sky = stats::local().SKY;
+  for (size_t level = d - 1; level > 0 && n; --level) {
+    std::vector<MASK> masks;
+    for (MASK m = 1; m < all; ++m) {
+      if ((size_t) __builtin_popcountll(m) == level) {
+        masks.push_back(m);
+      }
+    }
+    std::atomic<size_t> next(0);
+    parallel(workers < masks.size() ? workers : masks.size(), [&](size_t w) {
+      auto &method = *local[w];
+      auto &L = method.data();
+      lists sorted;
+      for (size_t k = next++; k < masks.size(); k = next++) {
+        auto m = masks[k];
+        // The smallest parent prunes the most.
+        MASK parent = 0;
+        for (size_t j = 0; j < d; ++j) {
+          auto p = m | 1ULL << j;
+          if (p != m && (!parent || extended[p].size() < extended[parent].size())) {
+            parent = p;
+          }
+        }
+        auto &e = extended[m];
+        if (level == 1) {
+          // The skyline of one dimension is its minimum value, ties and all.
+          auto j = __builtin_ctzll(m);
+          V min = L(extended[parent][0], j);
+          for (auto &&i : extended[parent]) {
+            min = L(i, j) < min ? L(i, j) : min;
+          }
+          for (auto &&i : extended[parent]) {
+            if (L(i, j) == min) {
+              membership_.set(i << d | m);
+              ++sizes_[m];
+            }
+          }
+          continue;
+        }
+        method.query(m, extended[parent]);
+        auto &skyline = method.skyline();
+        for (auto &&i : skyline) {
+          membership_.set(i << d | m);
+          e.push_back(i);
+        }
+        sizes_[m] = skyline.size();
+        // Dominated tuples with a tie in the subspace may still be only
+        // weakly dominated.
+        bool ready = false;
+        for (auto &&i : extended[parent]) {
+          if (!(ties[keys_[i]] & m) || L.skyline(i)) {
+            continue;
+          }
+          if (!ready) {
+            sort_(L, skyline, m, sorted);
+            ready = true;
+          }
+          if (!strict_(L, m, sorted, i)) {
+            e.push_back(i);
+          }
+        }
+        std::sort(e.begin(), e.end());
+      }
+      if (w) {
+        auto shard = stats::take();
+        std::lock_guard<std::mutex> guard(lock);
+        counts += shard;
+      }
+    });
+    // Parents are no longer needed.
+    for (MASK m = 1; m <= all; ++m) {
+      if ((size_t) __builtin_popcountll(m) == level + 1) {
+        std::vector<K>().swap(extended[m]);
+      }
+    }
+  }
+  for (auto &&method : local) {
+    delete method;
+  }
+  counts.SKY = 0;
+  stats::local() += counts;
+  stats::local().SKY = sky;
+}
+
+/**
+ * Sort the skyline tuples by value in each dimension of the mask.
+ */
+void skycube::sort_(const db &D, const std::vector<K> &skyline, MASK mask, lists &lists) {
+  lists.resize(D.width());
+  for (auto m = mask; m; m &= m - 1) {
+    auto j = __builtin_ctzll(m);
+    auto &l = lists[j];
+    l.clear();
+    for (auto &&k : skyline) {
+      l.emplace_back(D(k, j), k);
+    }
+    std::sort(l.begin(), l.end());
+  }
+}
+
+/**
+ * Whether a skyline tuple is better than the tuple key in every dimension
+ * of the mask. Only the skyline tuples strictly better in the dimension
+ * where they are the fewest are compared.
+ */
+auto skycube::strict_(const db &D, MASK mask, const lists &lists, K key) -> bool {
+  size_t best = 0;
+  size_t count = ~0ULL;
+  for (auto m = mask; m; m &= m - 1) {
+    auto j = __builtin_ctzll(m);
+    auto &l = lists[j];
+    auto n = (size_t) (std::lower_bound(l.begin(), l.end(), std::make_pair(D(key, j), (K) 0)) - l.begin());
+    if (n < count) {
+      best = j;
+      count = n;
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    auto s = lists[best][i].second;
+    bool strict = true;
+    for (auto m = mask; m && strict; m &= m - 1) {
+      auto j = __builtin_ctzll(m);
+      strict = D(s, j) < D(key, j);
+    }
+    if (strict) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * The skyline size of the subspace mask.
+ */
+auto skycube::size(MASK mask) const -> size_t {
+  return mask < sizes_.size() ? sizes_[mask] : 0;
+}
+
+auto skycube::statistics() const -> const stats & {
+  return stats_;
+}
+
+auto skycube::threads() const -> size_t {
+  return threads_;
+}
+
+void skycube::threads(size_t threads) {
+  threads_ = threads > 0 ? threads : 1;
+  method_.threads(threads_);
+}
+
+/**
+ * The tuples of the extended skyline of the whole space, the only ones
+ * that may belong to a subspace skyline.
+ */
+auto skycube::tuples() const -> const std::vector<K> & {
+  return keys_;
+}
+
+auto skycube::verify() const -> bool {
+  return method_.verify();
+}
+
+}
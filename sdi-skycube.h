@@ -0,0 +1,87 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef SDI_SKYCUBE_H
+#define SDI_SKYCUBE_H
+
+#include <istream>
+#include <utility>
+#include <vector>
+#include "sdi-bitset.h"
+#include "sdi.h"
+
+// Largest dimensionality of a skycube, 2^d bits are kept per tuple.
+#ifndef SDI_SKYCUBE_MAX
+#define SDI_SKYCUBE_MAX 16
+#endif
+
+namespace sdibench {
+
+/**
+ * The skylines of all 2^d - 1 subspaces. The skyline of the whole space is
+ * queried by sdi, then subspaces are computed level by level, each one
+ * from the extended skyline of its smallest parent: a tuple in the skyline
+ * of a subspace is never strictly dominated, in all of its dimensions, in
+ * a larger one. Each subspace is queried by sdi on an index of the
+ * extended skyline of the whole space, shared by all workers, all tuples
+ * but the ones of the parent being skipped. Membership is kept as 2^d bits per tuple of that
+ * extended skyline, bit m for the subspace m.
+ */
+class skycube {
+public:
+  explicit skycube(size_t, size_t);
+  explicit skycube(size_t, size_t, layout);
+  void build(const generator &);
+  void build(std::istream &);
+  auto build(const char *) -> bool;
+  auto contains(K, MASK) const -> bool;
+  auto memory() const -> size_t;
+  auto partial() const -> bool;
+  void query();
+  auto size(MASK) const -> size_t;
+  auto statistics() const -> const stats &;
+  auto threads() const -> size_t;
+  void threads(size_t);
+  auto tuples() const -> const std::vector<K> &;
+  auto verify() const -> bool;
+private:
+  typedef std::vector<std::vector<std::pair<V, K>>> lists;
+  static void sort_(const db &, const std::vector<K> &, MASK, lists &);
+  static auto strict_(const db &, MASK, const lists &, K) -> bool;
+  sdi method_;
+  std::vector<K> keys_; // The extended skyline of the whole space, by key.
+  std::vector<size_t> sizes_; // The skyline size of each subspace.
+  bitset membership_;
+  stats stats_; // The counts of the last query.
+  size_t dimensionality_ = 0;
+  size_t threads_ = 1;
+};
+
+}
+
+#endif //SDI_SKYCUBE_H
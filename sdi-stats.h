@@ -0,0 +1,113 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id$
+ */
+
+#ifndef SDI_STATS_H
+#define SDI_STATS_H
+
+#include <cstddef>
+
+// Counting sites compile to nothing without statistics.
+#ifdef WITHOUT_STATS
+#define SDI_COUNT(counter, n) ((void) (n))
+#else
+#define SDI_COUNT(counter, n) (sdibench::stats::local().counter += (n))
+#endif
+
+namespace sdibench {
+
+/**
+ * Algorithmic counters. Each thread counts in its own shard, local(); a
+ * scope collects the counts of one query into the stats of its instance,
+ * and parallel work adds the shards of its workers to the calling thread
+ * when they are done.
+ */
+struct stats {
+  class scope;
+  size_t DT = 0; // Dominance Test count
+  size_t DTE = 0; // Dominance Test Extended count
+  size_t IO = 0; // IO count
+  size_t SKY = 0; // Skyline size
+  size_t STOP = 0; // Stop line count
+  size_t TT = 0; // Tested tuple count
+  static auto local() -> stats &;
+  static auto take() -> stats;
+  auto operator+=(const stats &) -> stats &;
+};
+
+/**
+ * The counts of the calling thread between the construction and the
+ * destruction of a scope go to target, and stay counted in the enclosing
+ * scope.
+ */
+class stats::scope {
+public:
+  explicit scope(stats &target);
+  scope(const scope &) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  ~scope();
+private:
+  stats &target_;
+  stats outer_;
+};
+
+inline auto stats::local() -> stats & {
+  static thread_local stats shard;
+  return shard;
+}
+
+/**
+ * The counts of the calling thread, which start again from zero.
+ */
+inline auto stats::take() -> stats {
+  auto s = local();
+  local() = stats();
+  return s;
+}
+
+inline auto stats::operator+=(const stats &s) -> stats & {
+  DT += s.DT;
+  DTE += s.DTE;
+  IO += s.IO;
+  SKY += s.SKY;
+  STOP += s.STOP;
+  TT += s.TT;
+  return *this;
+}
+
+inline stats::scope::scope(stats &target) : target_(target), outer_(take()) {
+}
+
+inline stats::scope::~scope() {
+  target_ = take();
+  local() = outer_;
+  local() += target_;
+}
+
+}
+
+#endif //SDI_STATS_H
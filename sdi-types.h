@@ -31,10 +31,33 @@
 
 #include <cstddef>
 
+// The compact index uses 32-bit keys and offsets, it holds up to 2^32 - 1
+// tuples and cardinality * dimensionality must stay below 2^32.
+#ifdef WITH_COMPACT_INDEX
+typedef unsigned int KEY;
+typedef unsigned int OFFSET;
+#else
 typedef unsigned long long int KEY;
+typedef size_t OFFSET;
+#endif
 typedef KEY K;
+// A set of dimensions, one bit per dimension.
+typedef unsigned long long int MASK;
+// Values are doubles, floats with WITH_FLOAT, or 16-bit fixed point with
+// WITH_QUANTIZED, each dimension being scaled by the database. A bound
+// holds the sum of the values of a tuple.
+#if defined(WITH_QUANTIZED)
+typedef unsigned short VALUE;
+typedef unsigned int BOUND;
+#elif defined(WITH_FLOAT)
+typedef float VALUE;
+typedef float BOUND;
+#else
 typedef double VALUE;
+typedef double BOUND;
+#endif
 typedef VALUE V;
+typedef BOUND B;
 
 #ifndef BYTE
 #define BYTE 8
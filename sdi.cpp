@@ -26,13 +26,23 @@
  * $Id: sdi.cpp 568 2019-12-23 19:41:11Z li $
  */
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <list>
+#include <mutex>
 #include <vector>
+#include "parallel.h"
 #include "sdi.h"
+#include "timer.h"
 
 namespace sdibench {
 
-sdi::sdi(size_t cardinality, size_t dimensionality) : D_(cardinality, dimensionality), I_(D_) {
+sdi::sdi(size_t cardinality, size_t dimensionality) : sdi(cardinality, dimensionality, layout::row) {
+}
+
+sdi::sdi(size_t cardinality, size_t dimensionality, layout layout) : D_(cardinality, dimensionality, layout),
+                                                                     I_(D_) {
   cardinality_ = cardinality;
   dimensionality_ = dimensionality;
 #ifndef WITHOUT_STOPLINE
@@ -41,20 +51,353 @@ sdi::sdi(size_t cardinality, size_t dimensionality) : D_(cardinality, dimensiona
 #endif
 }
 
+/**
+ * A method on the rows [first, last) of the database source, without
+ * copying them. Keys of the skyline are relative to first.
+ */
+sdi::sdi(db &source, size_t first, size_t last) : D_(source, first, last), I_(D_) {
+  cardinality_ = last - first;
+  dimensionality_ = source.width();
+#ifndef WITHOUT_STOPLINE
+  max_ = dimensionality_;
+  mean_ = dimensionality_ + 1;
+#endif
+}
+
+/**
+ * A method on a copy of the given rows of the database source. Keys of the
+ * skyline are positions in rows.
+ */
+sdi::sdi(const db &source, const std::vector<K> &rows) : D_(source, rows), I_(D_) {
+  cardinality_ = rows.size();
+  dimensionality_ = source.width();
+#ifndef WITHOUT_STOPLINE
+  max_ = dimensionality_;
+  mean_ = dimensionality_ + 1;
+#endif
+}
+
+/**
+ * A method on all rows of the database source, without copying them,
+ * queried through shared, a built index of these rows. Both must outlive
+ * the method, which must not be updated.
+ */
+sdi::sdi(db &source, const index &shared) : D_(source, 0, source.height()), I_(D_, shared) {
+  cardinality_ = source.height();
+  dimensionality_ = source.width();
+#ifndef WITHOUT_STOPLINE
+  max_ = dimensionality_;
+  mean_ = dimensionality_ + 1;
+#endif
+  for (size_t i = 0; i < cardinality_; ++i) {
+    if (source.erased(i)) {
+      D_.erase(i);
+    }
+  }
+}
+
+/**
+ * Build the index of rows already held by the database.
+ */
+void sdi::build() {
+  phase p("build");
+  index_(nullptr);
+}
+
+/**
+ * Generate the data in place, then index them.
+ */
+void sdi::build(const generator &generator) {
+  phase p("build");
+  {
+    phase g("generate");
+    generator.generate(D_, threads_);
+  }
+  index_(nullptr);
+}
+
 void sdi::build(std::istream &in) {
-  in >> D_;
-  I_.build();
+  build(in, nullptr);
+}
+
+void sdi::build(std::istream &in, const char *snapshot) {
+  phase p("build");
+  {
+    phase r("parse");
+    in >> D_;
+  }
+  index_(snapshot);
+}
+
+auto sdi::build(const char *filename) -> bool {
+  return build(filename, nullptr);
+}
+
+auto sdi::build(const char *filename, const char *snapshot) -> bool {
+  phase p("build");
+  {
+    phase r("parse");
+    if (!D_.load(filename, threads_)) {
+      return false;
+    }
+  }
+  index_(snapshot);
+  return true;
+}
+
+auto sdi::data() const -> const db & {
+  return D_;
+}
+
+/**
+ * Test dominance on the dense ranks of the values, kept by the index, from
+ * the next build on.
+ */
+void sdi::dense(bool enabled) {
+  I_.dense(enabled);
+}
+
+/**
+ * The top-k dominating tuples, the k ones that dominate the most others,
+ * by decreasing scores(). A dominated tuple scores less than any of its
+ * dominators, so all of them are in the k-skyband. A band tuple can only
+ * dominate the tuples from its value on in the list where it ranks last:
+ * band tuples are scored by decreasing sizes of these lists, until one
+ * cannot beat the k-th score, SDI_BATCH at most in one pass over the rows.
+ */
+void sdi::dominating(size_t k) {
+  phase p("dominating");
+  stats::scope scope(stats_);
+  k = k > 0 ? k : 1;
+  // Band tuples are only candidates, the result is known at the end.
+  auto progress = progress_;
+  progress_ = nullptr;
+  skyband(k);
+  progress_ = progress;
+  band_ = 0;
+  phase s("scoring");
+  auto &D = D_;
+  auto &I = I_;
+  struct bound {
+    size_t size;
+    entry *first;
+    K key;
+  };
+  std::vector<bound> bounds;
+  for (auto &&key : S_) {
+    bound b{0, nullptr, key};
+    for (size_t d = 0; d < dimensionality_; ++d) {
+      auto list = I(d);
+      auto v = D(key, d);
+      auto at = std::lower_bound(list, list + cardinality_, v, [&](const entry &e, V x) {
+        return I.value(d, e) < x;
+      });
+      if (!b.first || (size_t) (list + cardinality_ - at) < b.size) {
+        b = bound{(size_t) (list + cardinality_ - at), at, key};
+      }
+    }
+    bounds.push_back(b);
+  }
+  std::sort(bounds.begin(), bounds.end(), [](const bound &x, const bound &y) {
+    return x.size > y.size || (x.size == y.size && x.key < y.key);
+  });
+  // The best k scores so far, by decreasing scores.
+  std::vector<std::pair<size_t, K>> top;
+  auto better = [](const std::pair<size_t, K> &x, const std::pair<size_t, K> &y) {
+    return x.first > y.first || (x.first == y.first && x.second < y.second);
+  };
+  // Candidates are scored by batches: each one marks the rows of its list
+  // in a mask per row, then rows are tested in one pass by key. The first
+  // batches are small so that the k-th score soon prunes the others.
+  std::vector<const bound *> batch;
+  std::vector<size_t> counts;
+  std::vector<unsigned long long> marks(cardinality_, 0);
+  size_t size = k < SDI_BATCH ? k : SDI_BATCH;
+  for (size_t i = 0; i < bounds.size(); size = size < SDI_BATCH / 2 ? size * 2 : SDI_BATCH) {
+    batch.clear();
+    for (; i < bounds.size() && batch.size() < size; ++i) {
+      if (top.size() == k && bounds[i].size <= top.back().first) {
+        i = bounds.size();
+        break;
+      }
+      batch.push_back(&bounds[i]);
+    }
+    for (size_t j = 0; j < batch.size(); ++j) {
+      for (auto e = batch[j]->first; e < batch[j]->first + batch[j]->size; ++e) {
+        marks[e->key] |= 1ULL << j;
+      }
+    }
+    counts.assign(batch.size(), 0);
+    for (size_t t = 0; t < cardinality_; ++t) {
+      for (auto m = marks[t]; m; m &= m - 1) {
+        auto j = __builtin_ctzll(m);
+        if (batch[j]->key != t && !D.erased(t) && D.dominate(batch[j]->key, t)) {
+          ++counts[j];
+        }
+      }
+      marks[t] = 0;
+    }
+    for (size_t j = 0; j < batch.size(); ++j) {
+      std::pair<size_t, K> p(counts[j], batch[j]->key);
+      top.insert(std::upper_bound(top.begin(), top.end(), p, better), p);
+      if (top.size() > k) {
+        top.pop_back();
+      }
+    }
+  }
+  S_.clear();
+  for (auto &&p : top) {
+    S_.push_back(p.second);
+    scores_.push_back(p.first);
+    if (progress_) {
+      progress_(p.second);
+    }
+  }
+}
+
+/**
+ * Remove the tuple key. When it was a skyline tuple, only the tuples it
+ * dominated are examined again, by increasing sums so that the ones that
+ * join the skyline are known before the tuples they dominate. The result
+ * of a k-skyband or top-k dominating query is left as is. An unknown or
+ * already erased key is ignored.
+ */
+void sdi::erase(K key) {
+  if (key >= D_.height() || D_.erased(key)) {
+    return;
+  }
+  bool skyline = queried_ && band_ == 1 && D_.skyline(key);
+  D_.erase(key);
+  touched_.push_back(key);
+  if (!skyline) {
+    return;
+  }
+  S_.erase(std::find(S_.begin(), S_.end(), key));
+  std::vector<K> region;
+  I_.region(key, region);
+  std::sort(region.begin(), region.end(), [&](K x, K y) {
+    return D_.sum(x) < D_.sum(y);
+  });
+  for (auto &&k : region) {
+    if (!S_.empty() && D_.dominated(S_.data(), S_.size(), k)) {
+      continue;
+    }
+    D_.skipped(k, false);
+    D_.skyline(k, true);
+    S_.push_back(k);
+  }
+}
+
+/**
+ * Add a tuple of dimensionality values, returns its key. The tuple is only
+ * tested against the skyline, and drops the skyline tuples it dominates.
+ * The index keeps new tuples pending and merges them by batches. As for
+ * erase(), only a skyline is kept up to date. Values are as stored, see
+ * db::quantize().
+ */
+auto sdi::insert(const V *row) -> K {
+  auto key = D_.append(row);
+  I_.insert(key);
+  if (I_.pending() * SDI_PENDING > I_.height()) {
+    I_.sync();
+  }
+  if (!queried_ || band_ != 1) {
+    return key;
+  }
+  if (!S_.empty() && D_.dominated(S_.data(), S_.size(), key)) {
+    D_.skipped(key, true);
+    touched_.push_back(key);
+    return key;
+  }
+  size_t n = 0;
+  for (auto &&s : S_) {
+    if (!D_.incomparable(key, s) && D_.dominate(key, s)) {
+      D_.skyline(s, false);
+      D_.skipped(s, true);
+      touched_.push_back(s);
+    } else {
+      S_[n++] = s;
+    }
+  }
+  S_.resize(n);
+  D_.skyline(key, true);
+  S_.push_back(key);
+  return key;
+}
+
+/**
+ * Call back on each result tuple as soon as a query confirms it, from one
+ * thread at a time; skyline tuples are final once found. A null function
+ * stops the calls.
+ */
+void sdi::progress(std::function<void(K)> progress) {
+  progress_ = std::move(progress);
 }
 
 void sdi::query() {
+  query(dimensionality_ < 64 ? (1ULL << dimensionality_) - 1 : ~0ULL);
+}
+
+/**
+ * The skyline of the subspace mask among the given tuples only, the others
+ * being skipped. The tuples must include every skyline tuple.
+ */
+void sdi::query(MASK mask, const std::vector<K> &candidates) {
+  candidates_ = &candidates;
+  query(mask);
+  candidates_ = nullptr;
+}
+
+/**
+ * The skyline of the subspace given by mask, on the index of the whole
+ * space: only the lists, offsets and values of its dimensions are used. A
+ * mask without any dimension of the data is the whole space.
+ */
+void sdi::query(MASK mask) {
+  phase p("query");
+  stats::scope scope(stats_);
+  {
+    phase r("reset");
+    reset();
+  }
+  phase t("traversal");
+  I_.sync();
+  cardinality_ = I_.height();
+  queried_ = true;
+  band_ = 1;
+  MASK all = dimensionality_ < 64 ? (1ULL << dimensionality_) - 1 : ~0ULL;
+  mask_ = mask & all ? mask & all : all;
+  D_.subspace(mask_);
+  I_.subspace(mask_);
+  if (candidates_) {
+    // After a query among candidates, only those rows were cleared, all
+    // others staying skipped.
+    if (isolated_) {
+      for (auto &&k : *candidates_) {
+        D_.clear(k);
+      }
+    } else {
+      D_.reset(candidates_);
+    }
+    chosen_.assign(candidates_->begin(), candidates_->end());
+    isolated_ = true;
+  } else if (isolated_) {
+    D_.reset();
+    isolated_ = false;
+  }
+  walked_.assign(dimensionality_, 0);
+  if (threads_ > 1 && __builtin_popcountll(mask_) > 1) {
+    parallel_();
+    return;
+  }
   auto &D = D_;
   auto &I = I_;
   auto &S = S_;
   std::vector<entry *> block;
-  std::vector<size_t> its(dimensionality_, 0);
+  auto &its = walked_;
   std::vector<V> itv(dimensionality_);
   for (size_t d = 0; d < dimensionality_; ++d) {
-    itv[d] = I(d)->value;
+    itv[d] = I.value(d, *I(d));
   }
   bool stop = false;
 #ifndef WITHOUT_STOPLINE
@@ -67,7 +410,7 @@ void sdi::query() {
     // Dimension switching loop.
     size_t d = I.best();
 #ifndef WITHOUT_STOPLINE
-    if (stopped_ >= dimensionality_) {
+    if (stopped_ >= (size_t) __builtin_popcountll(mask_)) {
       break;
     }
 #endif
@@ -89,7 +432,7 @@ void sdi::query() {
       // Record tested tuples.
       if (!D.tested(e.key)) {
         D.tested(e.key, true);
-        ++db::TT;
+        SDI_COUNT(TT, 1);
       }
       // Anyway, if stop, do block skyline commit and quit the loop.
       if (stop) {
@@ -99,7 +442,8 @@ void sdi::query() {
       }
       // Treat block skyline.
       size_t sky = 0;
-      if (e.value == itv[d]) {
+      auto value = I.value(d, e);
+      if (value == itv[d]) {
         // Add current tuple to the block.
         block.push_back(&e);
       } else {
@@ -107,7 +451,7 @@ void sdi::query() {
         // Roll back current dimension pointer.
         sky = skyline_(block, d);
         block.clear();
-        itv[d] = e.value;
+        itv[d] = value;
         --its[d];
 #ifndef WITHOUT_STOPLINE
         if (stopline_ && its[d] > stopline_[d]) {
@@ -127,10 +471,465 @@ void sdi::query() {
   }
 }
 
+/**
+ * Bytes held by the database, the index and the skyline.
+ */
+auto sdi::memory() const -> size_t {
+  return D_.memory() + I_.memory() + S_.capacity() * sizeof(K);
+}
+
+auto sdi::partial() const -> bool {
+  return D_.partial();
+}
+
+/**
+ * Clear the state of the last query, so that the next one starts afresh.
+ * Only the rows the query walked or updates touched are visited, then the
+ * skyline; after a query among candidates, only the candidates, the rows
+ * updates touched and the skyline are skipped again, as all other rows
+ * are. Inserts may have merged the lists since, in which case all rows are
+ * cleared.
+ */
+void sdi::reset() {
+  if (!queried_) {
+    return;
+  }
+  if (I_.height() != cardinality_) {
+    D_.reset();
+    isolated_ = false;
+  } else if (isolated_) {
+    for (auto &&k : chosen_) {
+      D_.clear(k);
+      D_.skipped(k, true);
+    }
+    for (auto &&k : touched_) {
+      D_.clear(k);
+      D_.skipped(k, true);
+    }
+    for (auto &&k : S_) {
+      D_.clear(k);
+      D_.skipped(k, true);
+    }
+  } else {
+    for (size_t d = 0; d < walked_.size(); ++d) {
+      auto list = I_(d);
+      auto n = walked_[d] < cardinality_ ? walked_[d] + 1 : cardinality_;
+      for (size_t i = 0; i < n; ++i) {
+        D_.clear(list[i].key);
+      }
+    }
+    for (auto &&k : touched_) {
+      D_.clear(k);
+    }
+    for (auto &&k : S_) {
+      D_.clear(k);
+    }
+  }
+  I_.reset();
+  S_.clear();
+  scores_.clear();
+  touched_.clear();
+  walked_.clear();
+  chosen_.clear();
+  queried_ = false;
+}
+
+/**
+ * Scale the quantized values of a dimension to [min, max] before a build,
+ * rather than to the range of its values, see db::scale().
+ */
+void sdi::scale(size_t dimension, double min, double max) {
+  D_.scale(dimension, min, max);
+}
+
+/**
+ * Whether the snapshot of the last build, if any, could be written.
+ */
+auto sdi::saved() const -> bool {
+  return saved_;
+}
+
+/**
+ * The number of tuples each tuple of a top-k dominating query dominates.
+ */
+auto sdi::scores() const -> const std::vector<size_t> & {
+  return scores_;
+}
+
+/**
+ * The k-skyband, the tuples dominated by fewer than k others, in skyline().
+ * Lists are walked as by query(), in one thread: a tuple met for the first
+ * time counts its dominators among the band tuples met before it in the
+ * list, which hold the first k of them. The walk stops once every list
+ * passed the worst rank of k band tuples in it, as the tuples beyond are
+ * dominated by all k.
+ */
+void sdi::skyband(size_t k) {
+  phase p("skyband");
+  stats::scope scope(stats_);
+  {
+    phase r("reset");
+    reset();
+  }
+  phase t("traversal");
+  I_.sync();
+  cardinality_ = I_.height();
+  queried_ = true;
+  band_ = k > 0 ? k : 1;
+  mask_ = 0;
+  D_.subspace(mask_);
+  I_.subspace(mask_);
+  if (isolated_) {
+    D_.reset();
+    isolated_ = false;
+  }
+  walked_.assign(dimensionality_, 0);
+  if (!cardinality_) {
+    return;
+  }
+  auto &D = D_;
+  auto &I = I_;
+  auto &its = walked_;
+  std::vector<K> block;
+  std::vector<V> itv(dimensionality_);
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    itv[d] = I.value(d, *I(d));
+  }
+#ifndef WITHOUT_STOPLINE
+  line_.clear();
+  limits_.assign(dimensionality_, 0);
+  stopped_ = 0;
+#endif
+  for (;;) {
+    size_t d = I.best();
+#ifndef WITHOUT_STOPLINE
+    if (stopped_ >= dimensionality_) {
+      break;
+    }
+#endif
+    while (its[d] < cardinality_) {
+      auto &&e = I(d)[its[d]];
+      auto value = I.value(d, e);
+      if (value != itv[d]) {
+        // The block of equal values is complete, switch dimension on any
+        // new band tuple.
+        size_t found = skyband_(block, d);
+        block.clear();
+        itv[d] = value;
+#ifndef WITHOUT_STOPLINE
+        if (line_.size() == band_ && its[d] > limits_[d]) {
+          stopped_ = I.stop(d);
+          break;
+        }
+#endif
+        if (found) {
+          break;
+        }
+      }
+      ++its[d];
+      if (D.skipped(e.key)) {
+        continue;
+      }
+      if (!D.tested(e.key)) {
+        D.tested(e.key, true);
+        SDI_COUNT(TT, 1);
+      }
+      block.push_back(e.key);
+    }
+    if (its[d] == cardinality_) {
+      skyband_(block, d);
+      break;
+    }
+  }
+}
+
+auto sdi::skyline() const -> const std::vector<K> & {
+  return S_;
+}
+
+auto sdi::statistics() const -> const stats & {
+  return stats_;
+}
+
+auto sdi::threads() const -> size_t {
+  return threads_;
+}
+
+void sdi::threads(size_t threads) {
+  threads_ = threads > 0 ? threads : 1;
+}
+
+auto sdi::verify() const -> bool {
+  return D_.verify();
+}
+
+void sdi::index_(const char *snapshot) {
+  phase p("index");
+  stats::scope scope(stats_);
+  // A snapshot of another dataset is refused by index::load(), the index
+  // is then rebuilt and the snapshot replaced.
+  saved_ = true;
+  if (snapshot && I_.load(snapshot)) {
+    return;
+  }
+  I_.build(threads_);
+  saved_ = !snapshot || I_.save(snapshot);
+}
+
+/**
+ * The parallel query: up to one worker per dimension, each one walking its
+ * own dimensions in turn. A dimension is only ever walked by one worker, in
+ * order, so that its dimensional skyline holds every skyline tuple met
+ * before the current one and the result is the one of the serial query.
+ * Workers share the row flags through atomic bitsets and the stop line
+ * under a lock; a dimension that passed the stop line waits until a better
+ * stop tuple moves it, and the query ends once all dimensions passed it or
+ * one dimension is exhausted.
+ */
+void sdi::parallel_() {
+  auto &D = D_;
+  auto &I = I_;
+  std::vector<size_t> dims;
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    if (mask_ >> d & 1) {
+      dims.push_back(d);
+    }
+  }
+  size_t workers = threads_ < dims.size() ? threads_ : dims.size();
+  auto &its = walked_;
+  std::vector<V> itv(dimensionality_);
+  std::vector<std::vector<entry *>> blocks(dimensionality_);
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    itv[d] = I.value(d, *I(d));
+  }
+  std::vector<std::vector<K>> found(workers);
+  std::mutex lock;
+  std::mutex emit;
+  std::condition_variable wake;
+  std::atomic<bool> done(false);
+  std::vector<char> passed(dimensionality_, 0);
+#ifndef WITHOUT_STOPLINE
+  size_t count = 0;
+  std::atomic<bool> stopping(false);
+  std::atomic<K> stop(0);
+#endif
+  stats counts;
+  // Block skyline commit, as in skyline_() with concurrent flag updates.
+  auto commit = [&](std::vector<entry *> &block, size_t d, std::vector<K> &S) -> size_t {
+    if (block.size() > 1) {
+      for (size_t i = 0; i < block.size() - 1; ++i) {
+        if (!block[i]) {
+          continue;
+        }
+        auto ik = block[i]->key;
+        if (D.skipped(ik)) {
+          block[i] = nullptr;
+          continue;
+        }
+        auto is = D.skyline(ik);
+        for (size_t j = i + 1; j < block.size(); ++j) {
+          if (!block[j]) {
+            continue;
+          }
+          auto jk = block[j]->key;
+          if (D.skipped(jk)) {
+            block[j] = nullptr;
+            continue;
+          }
+          auto js = D.skyline(jk);
+          if (is && js) {
+            continue;
+          } else if (!js && D.dominate(ik, jk)) {
+            D.skip(jk);
+            block[j] = nullptr;
+          } else if (!is && D.dominate(jk, ik)) {
+            D.skip(ik);
+            block[i] = nullptr;
+            break;
+          }
+        }
+      }
+    }
+    size_t sky = 0;
+    for (auto &&x : block) {
+      if (!x) {
+        continue;
+      }
+      auto xk = x->key;
+      if (!D.skyline(xk) && I.dominate(d, xk)) {
+        D.skip(xk);
+        continue;
+      }
+      I.skyline(d, xk);
+      if (!D.claim(xk)) {
+        continue;
+      }
+      S.push_back(xk);
+      SDI_COUNT(SKY, 1);
+      ++sky;
+      if (progress_) {
+        std::lock_guard<std::mutex> guard(emit);
+        progress_(xk);
+      }
 #ifndef WITHOUT_STOPLINE
+      std::lock_guard<std::mutex> guard(lock);
+      auto best = stopping ? better_(stop, xk) : xk;
+      if (!stopping || best != stop) {
+        stop = best;
+        stopping = true;
+        SDI_COUNT(STOP, 1);
+        std::fill(passed.begin(), passed.end(), 0);
+        count = 0;
+        wake.notify_all();
+      }
+#endif
+    }
+    return sky;
+  };
+  parallel(workers, [&](size_t t) {
+    auto &S = found[t];
+    size_t next = t;
+    // The next dimension of the worker that has not passed the stop line.
+    auto pick = [&]() -> size_t {
+      for (size_t i = t; i < dims.size(); i += workers) {
+        size_t d = dims[next];
+        next = next + workers < dims.size() ? next + workers : t;
+        if (!passed[d]) {
+          return d;
+        }
+      }
+      return dimensionality_;
+    };
+    for (;;) {
+      size_t d = dimensionality_;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        wake.wait(guard, [&] {
+          return done || (d = pick()) < dimensionality_;
+        });
+        if (done) {
+          break;
+        }
+      }
+      bool last = false;
+      while (its[d] < cardinality_) {
+        auto dp = its[d]++;
+        last = its[d] == cardinality_;
+        auto &&e = I(d)[dp];
+        if (D.skipped(e.key)) {
+          if (last) {
+            commit(blocks[d], d, S);
+          }
+          continue;
+        }
+        if (D.visit(e.key)) {
+          SDI_COUNT(TT, 1);
+        }
+        if (last) {
+          blocks[d].push_back(&e);
+          commit(blocks[d], d, S);
+          break;
+        }
+        size_t sky = 0;
+        auto value = I.value(d, e);
+        if (value == itv[d]) {
+          blocks[d].push_back(&e);
+        } else {
+          sky = commit(blocks[d], d, S);
+          blocks[d].clear();
+          itv[d] = value;
+          --its[d];
+#ifndef WITHOUT_STOPLINE
+          // Checked without the lock first, then again under it in case
+          // the stop tuple just changed.
+          if (stopping && its[d] > I.offsets(stop)[d]) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (its[d] > I.offsets(stop)[d]) {
+              passed[d] = 1;
+              if (++count == dims.size()) {
+                done = true;
+                wake.notify_all();
+              }
+              break;
+            }
+          }
+#endif
+        }
+        if (sky) {
+          break;
+        }
+      }
+      if (last) {
+        std::lock_guard<std::mutex> guard(lock);
+        done = true;
+        wake.notify_all();
+      }
+    }
+    if (t) {
+      auto shard = stats::take();
+      std::lock_guard<std::mutex> guard(lock);
+      counts += shard;
+    }
+  });
+  stats::local() += counts;
+  for (auto &&s : found) {
+    S_.insert(S_.end(), s.begin(), s.end());
+  }
+}
+
+#ifndef WITHOUT_STOPLINE
+/**
+ * Add a band tuple to the stop line of a k-skyband, made of the k band
+ * tuples of lowest max then mean ranks. The limit of a dimension is the
+ * worst rank of these tuples in it.
+ */
+void sdi::limit_(K key) {
+  auto less = [&](K x, K y) {
+    auto ox = I_.offsets(x);
+    auto oy = I_.offsets(y);
+    return ox[max_] < oy[max_] || (ox[max_] == oy[max_] && ox[mean_] < oy[mean_]);
+  };
+  if (line_.size() == band_ && !less(key, line_.back())) {
+    return;
+  }
+  line_.insert(std::upper_bound(line_.begin(), line_.end(), key, less), key);
+  if (line_.size() > band_) {
+    line_.pop_back();
+  }
+  if (line_.size() < band_) {
+    return;
+  }
+  for (size_t d = 0; d < dimensionality_; ++d) {
+    limits_[d] = 0;
+    for (auto &&k : line_) {
+      limits_[d] = limits_[d] < I_.offsets(k)[d] ? I_.offsets(k)[d] : limits_[d];
+    }
+  }
+  I_.stop();
+  SDI_COUNT(STOP, 1);
+}
+
 auto sdi::better_(K key1, K key2) -> K {
   auto o1 = I_.offsets(key1);
   auto o2 = I_.offsets(key2);
+  if (D_.subspace()) {
+    // Max and mean ranks of the subspace.
+    size_t max1 = 0;
+    size_t max2 = 0;
+    size_t mean1 = 0;
+    size_t mean2 = 0;
+    for (auto m = mask_; m; m &= m - 1) {
+      auto d = __builtin_ctzll(m);
+      max1 = o1[d] > max1 ? o1[d] : max1;
+      max2 = o2[d] > max2 ? o2[d] : max2;
+      mean1 += o1[d];
+      mean2 += o2[d];
+    }
+    if (max1 != max2) {
+      return max1 < max2 ? key1 : key2;
+    }
+    return mean1 < mean2 ? key1 : key2;
+  }
   if (o1[max_] < o2[max_]) {
     return key1;
   } else if (o2[max_] < o1[max_]) {
@@ -144,18 +943,57 @@ auto sdi::better_(K key1, K key2) -> K {
 }
 #endif
 
+/**
+ * Commit a block of equal values of dimension d to the k-skyband, returns
+ * the number of new band tuples. A tuple is only dominated by tuples of
+ * lower sums, which come first.
+ */
+auto sdi::skyband_(std::vector<K> &block, size_t d) -> size_t {
+  auto &D = D_;
+  auto &I = I_;
+  std::sort(block.begin(), block.end(), [&](K x, K y) {
+    return D.sum(x) < D.sum(y);
+  });
+  size_t found = 0;
+  for (auto &&key : block) {
+    if (D.skyline(key)) {
+      I.skyline(d, key);
+      continue;
+    }
+    if (I.dominators(d, key, band_) == band_) {
+      D.skipped(key, true);
+      continue;
+    }
+    D.skyline(key, true);
+    I.skyline(d, key);
+    S_.push_back(key);
+    SDI_COUNT(SKY, 1);
+    ++found;
+    if (progress_) {
+      progress_(key);
+    }
+#ifndef WITHOUT_STOPLINE
+    limit_(key);
+#endif
+  }
+  return found;
+}
+
 auto sdi::skyline_(std::vector<entry *> &block, size_t d) -> size_t {
   auto &D = D_;
   auto &I = I_;
   auto &S = S_;
   if (block.size() > 1) {
+#ifdef WITH_PHASES
+    phase p("block");
+#endif
     for (size_t i = 0; i < block.size() - 1; ++i) {
       if (!block[i]) {
         continue;
       }
       auto ik = block[i]->key;
       if (D.skipped(ik)) {
-        block[ik] = nullptr;
+        block[i] = nullptr;
         continue;
       }
       auto is = D.skyline(ik);
@@ -195,15 +1033,18 @@ auto sdi::skyline_(std::vector<entry *> &block, size_t d) -> size_t {
         D.skyline(xk, true);
         I.skyline(d, xk);
         S.push_back(xk);
-        ++db::SKY;
+        SDI_COUNT(SKY, 1);
         ++sky;
+        if (progress_) {
+          progress_(xk);
+        }
 #ifndef WITHOUT_STOPLINE
         auto best = stopline_ ? better_(stop_, xk) : xk;
         if (best != stop_) {
           I.stop();
           stop_ = best;
           stopline_ = I.offsets(stop_);
-          ++db::STOP;
+          SDI_COUNT(STOP, 1);
         }
 #endif
       }
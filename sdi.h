@@ -29,32 +29,96 @@
 #ifndef SDI_H
 #define SDI_H
 
+#include <functional>
 #include <istream>
 #include <vector>
 #include "sdi-db.h"
+#include "sdi-generator.h"
 #include "sdi-index.h"
+#include "sdi-stats.h"
+
+// Pending tuples are merged into the index once they outnumber 1/SDI_PENDING
+// of the indexed ones.
+#ifndef SDI_PENDING
+#define SDI_PENDING 16
+#endif
+
+// Band tuples scored together in one pass by a top-k dominating query, one
+// bit each in a 64-bit mask per row.
+#ifndef SDI_BATCH
+#define SDI_BATCH 64
+#endif
 
 namespace sdibench {
 
 class sdi {
+  friend class skycube;
 public:
   explicit sdi(size_t, size_t);
+  explicit sdi(size_t, size_t, layout);
+  explicit sdi(db &, size_t, size_t);
+  explicit sdi(const db &, const std::vector<K> &);
+  explicit sdi(db &, const index &);
+  void build();
+  void build(const generator &);
   void build(std::istream &in);
+  void build(std::istream &in, const char *);
+  auto build(const char *) -> bool;
+  auto build(const char *, const char *) -> bool;
+  void dense(bool);
+  void dominating(size_t);
+  void erase(K);
+  auto insert(const V *) -> K;
   void query();
+  void query(MASK);
+  void query(MASK, const std::vector<K> &);
+  void reset();
+  auto data() const -> const db &;
+  auto memory() const -> size_t;
+  auto partial() const -> bool;
+  void progress(std::function<void(K)>);
+  void scale(size_t, double, double);
+  auto saved() const -> bool;
+  auto scores() const -> const std::vector<size_t> &;
+  void skyband(size_t);
+  auto skyline() const -> const std::vector<K> &;
+  auto statistics() const -> const stats &;
+  auto threads() const -> size_t;
+  void threads(size_t);
+  auto verify() const -> bool;
 private:
+  void index_(const char *);
+  void parallel_();
+  auto skyband_(std::vector<K> &, size_t) -> size_t;
   auto skyline_(std::vector<entry *> &, size_t) -> size_t;
   db D_;
   index I_;
   std::vector<K> S_;
+  std::vector<size_t> scores_;
+  std::function<void(K)> progress_;
+  stats stats_; // The counts of the last build or query.
+  size_t band_ = 1; // The k of the last query, 0 for a top-k dominating one.
   size_t cardinality_ = 0;
   size_t dimensionality_ = 0;
+  size_t threads_ = 1;
+  bool saved_ = true; // False when the last snapshot could not be written.
+  bool queried_ = false;
+  MASK mask_ = 0;
+  const std::vector<K> *candidates_ = nullptr;
+  std::vector<size_t> walked_; // The walk positions of the last query.
+  std::vector<K> touched_; // The rows updates flagged since.
+  std::vector<K> chosen_; // The candidates of the last query.
+  bool isolated_ = false; // Whether all rows but chosen_ are skipped.
 #ifndef WITHOUT_STOPLINE
   auto better_(K, K) -> K;
   size_t max_ = 0;
   size_t mean_ = 0;
   K stop_ = 0;
-  size_t *stopline_ = nullptr;
+  OFFSET *stopline_ = nullptr;
   size_t stopped_ = 0;
+  void limit_(K);
+  std::vector<K> line_; // The band tuples of the stop line of a k-skyband.
+  std::vector<OFFSET> limits_; // Their worst rank in each dimension.
 #endif
 };
 
@@ -29,16 +29,45 @@
 #ifndef SORT_H
 #define SORT_H
 
+#include <algorithm>
+#include "parallel.h"
+
+/**
+ * The default order of the sorts, given by operator<.
+ */
+template<class _T>
+struct ascending {
+  auto operator()(const _T &x, const _T &y) const -> bool {
+    return x < y;
+  }
+};
+
 template<class _T>
 void msort(_T *, size_t);
 template<class _T>
 void msort(_T *, size_t, bool);
+template<class _T, class _C>
+void msort(_T *, size_t, _C);
 template<class _T>
 void msort(_T *, size_t, size_t, _T *);
+template<class _T, class _C>
+void msort(_T *, size_t, size_t, _T *, _C);
 template<class _T>
 void merge(_T *, size_t, size_t, size_t, _T *);
+template<class _T, class _C>
+void merge(_T *, size_t, size_t, size_t, _T *, _C);
 template<class _T>
 void merge(_T *, size_t, _T *, size_t, _T *);
+template<class _T, class _C>
+void merge(_T *, size_t, _T *, size_t, _T *, _C);
+template<class _T>
+void psort(_T *, size_t, size_t);
+template<class _T, class _S>
+void psort(_T *, size_t, size_t, _S);
+template<class _T, class _S, class _C>
+void psort(_T *, size_t, size_t, _S, _C);
+template<class _T, class _K>
+void rsort(_T *, size_t, _K);
 
 template<class _T>
 void msort(_T *a, size_t length) {
@@ -58,13 +87,27 @@ void msort(_T *a, size_t length, bool unique) {
   delete[] tmp;
 }
 
+template<class _T, class _C>
+void msort(_T *a, size_t length, _C less) {
+  if (!length)
+    return;
+  _T *tmp = new _T[length];
+  msort(a, 0, length - 1, tmp, less);
+  delete[] tmp;
+}
+
 template<class _T>
 void msort(_T *a, size_t first, size_t last, _T *tmp) {
+  msort(a, first, last, tmp, ascending<_T>());
+}
+
+template<class _T, class _C>
+void msort(_T *a, size_t first, size_t last, _T *tmp, _C less) {
   if (first < last) {
     size_t middle = (first + last) / 2;
-    msort(a, first, middle, tmp);
-    msort(a, middle + 1, last, tmp);
-    merge(a, first, middle, last, tmp);
+    msort(a, first, middle, tmp, less);
+    msort(a, middle + 1, last, tmp, less);
+    merge(a, first, middle, last, tmp, less);
   }
 }
 
@@ -74,7 +117,12 @@ void msort(_T *a, size_t first, size_t last, _T *tmp) {
  */
 template<class _T>
 void merge(_T *x, size_t lo, size_t mi, size_t hi, _T *z) {
-  merge(x + lo, mi - lo + 1, x + mi + 1, hi - mi, z);
+  merge(x, lo, mi, hi, z, ascending<_T>());
+}
+
+template<class _T, class _C>
+void merge(_T *x, size_t lo, size_t mi, size_t hi, _T *z, _C less) {
+  merge(x + lo, mi - lo + 1, x + mi + 1, hi - mi, z, less);
   for (size_t i = 0; i <= hi - lo; ++i)
     *(x + lo + i) = *(z + i);
 }
@@ -85,10 +133,15 @@ void merge(_T *x, size_t lo, size_t mi, size_t hi, _T *z) {
  */
 template<class _T>
 void merge(_T *x, size_t m, _T *y, size_t n, _T *z) {
+  merge(x, m, y, n, z, ascending<_T>());
+}
+
+template<class _T, class _C>
+void merge(_T *x, size_t m, _T *y, size_t n, _T *z, _C less) {
   size_t i = 0;
   size_t j = 0;
   for (; i < m && j < n;) {
-    if (*x < *y) {
+    if (less(*x, *y)) {
       *z++ = *x++;
       ++i;
     } else {
@@ -102,4 +155,126 @@ void merge(_T *x, size_t m, _T *y, size_t n, _T *z) {
     *z++ = *y++;
 }
 
+/**
+ * Map a double to an unsigned integer of the same order, so that radix
+ * sorting the integers sorts the doubles. Both zeros map to the same key.
+ */
+inline auto radix(double v) -> unsigned long long {
+  union {
+    double v;
+    unsigned long long u;
+  } x{};
+  x.v = v == 0 ? 0.0 : v;
+  return x.u >> 63 ? ~x.u : x.u | 1ULL << 63;
+}
+
+/**
+ * Sort the block a of size length with the given number of threads, each
+ * run being sorted by msort.
+ */
+template<class _T>
+void psort(_T *a, size_t length, size_t threads) {
+  psort(a, length, threads, [](_T *x, size_t n) {
+    msort(x, n);
+  });
+}
+
+/**
+ * Sort the block a of size length with the given number of threads. The
+ * block is cut into one run per thread, each run is sorted by sort(x, n),
+ * then runs are merged pairwise, one merge per thread, between a and a
+ * buffer.
+ */
+template<class _T, class _S>
+void psort(_T *a, size_t length, size_t threads, _S sort) {
+  psort(a, length, threads, sort, ascending<_T>());
+}
+
+/**
+ * As above, runs being merged in the order given by less.
+ */
+template<class _T, class _S, class _C>
+void psort(_T *a, size_t length, size_t threads, _S sort, _C less) {
+  if (threads > length / 2) {
+    threads = length / 2;
+  }
+  if (threads < 2) {
+    sort(a, length);
+    return;
+  }
+  std::vector<size_t> runs(threads + 1, 0);
+  for (size_t t = 0; t <= threads; ++t) {
+    runs[t] = length * t / threads;
+  }
+  parallel(threads, [&](size_t t) {
+    sort(a + runs[t], runs[t + 1] - runs[t]);
+  });
+  _T *tmp = new _T[length];
+  _T *x = a;
+  _T *z = tmp;
+  for (size_t width = 1; width < threads; width *= 2) {
+    size_t pairs = (threads + 2 * width - 1) / (2 * width);
+    parallel(pairs, [&](size_t p) {
+      size_t lo = runs[2 * p * width];
+      size_t mi = runs[std::min(threads, (2 * p + 1) * width)];
+      size_t hi = runs[std::min(threads, (2 * p + 2) * width)];
+      merge(x + lo, mi - lo, x + mi, hi - mi, z + lo, less);
+    });
+    std::swap(x, z);
+  }
+  if (x != a) {
+    parallel(threads, length, [&](size_t first, size_t last) {
+      std::copy(x + first, x + last, a + first);
+    });
+  }
+  delete[] tmp;
+}
+
+/**
+ * Stable LSD radix sort of the block a of size length on the 64-bit keys
+ * given by key(a[i]), 11 bits per pass. All digit histograms are counted in
+ * one pass over a, and passes where every element has the same digit are
+ * skipped. Elements move between a and a buffer of the same size.
+ */
+template<class _T, class _K>
+void rsort(_T *a, size_t length, _K key) {
+  const size_t bits = 11;
+  const size_t radix = 1 << bits;
+  const size_t passes = (64 + bits - 1) / bits;
+  if (length < 2) {
+    return;
+  }
+  std::vector<size_t> count(passes * radix, 0);
+  for (size_t i = 0; i < length; ++i) {
+    auto k = key(a[i]);
+    for (size_t p = 0; p < passes; ++p) {
+      ++count[p * radix + ((k >> (p * bits)) & (radix - 1))];
+    }
+  }
+  _T *tmp = new _T[length];
+  _T *x = a;
+  _T *z = tmp;
+  auto first = key(a[0]);
+  for (size_t p = 0; p < passes; ++p) {
+    auto c = &count[p * radix];
+    if (c[(first >> (p * bits)) & (radix - 1)] == length) {
+      continue;
+    }
+    size_t sum = 0;
+    for (size_t r = 0; r < radix; ++r) {
+      auto n = c[r];
+      c[r] = sum;
+      sum += n;
+    }
+    for (size_t i = 0; i < length; ++i) {
+      z[c[(key(x[i]) >> (p * bits)) & (radix - 1)]++] = x[i];
+    }
+    std::swap(x, z);
+  }
+  if (x != a) {
+    std::copy(x, x + length, a);
+  }
+  delete[] tmp;
+}
+
 #endif //SORT_H
@@ -27,9 +27,45 @@
  */
 
 #include <ctime>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <sys/time.h>
 #include "timer.h"
 
+/**
+ * Times of a phase path over all its calls, in seconds.
+ */
+struct record {
+  std::string path;
+  size_t calls;
+  double wall;
+  double cpu;
+  double events[PERF_COUNTERS];
+};
+
+static std::mutex mutex;
+static std::vector<record> records;
+static std::unordered_map<std::string, size_t> paths;
+static thread_local std::vector<const std::string *> opened;
+// Statics are initialized before main() runs, on the main thread.
+static const std::thread::id main_thread = std::this_thread::get_id();
+
+static auto seconds(clockid_t id) -> double {
+  struct timespec t{};
+  clock_gettime(id, &t);
+  return t.tv_sec + t.tv_nsec / 1000000000.0;
+}
+
+static auto seconds(std::chrono::steady_clock::duration d) -> double {
+  return std::chrono::duration<double>(d).count();
+}
+
+auto timer::cputime() -> double {
+  return seconds(CLOCK_THREAD_CPUTIME_ID);
+}
+
 auto timer::microtime() -> double {
   struct timeval t{};
   gettimeofday(&t, (struct timezone *) nullptr);
@@ -40,30 +76,135 @@ auto timer::now() -> time_t {
   return time(nullptr);
 }
 
+timer::timer(bool cpu) : cpu_(cpu) {
+}
+
+/**
+ * The CPU time of the thread in seconds, over all start-stop periods; zero
+ * unless the timer was constructed with cpu set.
+ */
+auto timer::cpu() const -> double {
+  return cpu_total_;
+}
+
 auto timer::reset() -> double {
-  stop_ = 0;
-  total_ = 0;
-  return start_ = clock();
+  total_ = clock::duration::zero();
+  cpu_total_ = 0;
+  return start();
 }
 
+/**
+ * The wall time in seconds of the last start-stop period, or since the
+ * last start if the timer runs.
+ */
 auto timer::runtime() -> double {
-  if (!stop_) {
-    stop_ = clock();
-  }
-  return (double) (stop_ - start_) / CLOCKS_PER_SEC;
+  return seconds((stopped_ ? stop_ : clock::now()) - start_);
 }
 
 auto timer::start() -> double {
-  stop_ = 0;
-  return start_ = clock();
+  stopped_ = false;
+  if (cpu_) {
+    cpu_start_ = cputime();
+  }
+  start_ = clock::now();
+  return seconds(start_.time_since_epoch());
 }
 
 auto timer::stop() -> double {
-  stop_ = clock();
+  stop_ = clock::now();
+  if (cpu_) {
+    cpu_total_ += cputime() - cpu_start_;
+  }
+  stopped_ = true;
   total_ += stop_ - start_;
-  return stop_;
+  return seconds(stop_.time_since_epoch());
 }
 
+/**
+ * The wall time in seconds over all start-stop periods.
+ */
 auto timer::total() -> double {
-  return (double) total_ / CLOCKS_PER_SEC;
+  return seconds(total_);
+}
+
+/**
+ * Forget all paths; no phase may be open.
+ */
+void phase::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  records.clear();
+  paths.clear();
+}
+
+/**
+ * Write one line of times per path, in the order the paths were first
+ * opened, then one line of counters per path if they were opened, each
+ * kind after a header line; unavailable counters are written "-".
+ */
+void phase::report(std::ostream &out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!records.empty()) {
+    out << "# Phase | Calls | Wall Time (ms) | CPU Time (ms)" << std::endl;
+  }
+  for (auto &&r : records) {
+    out << "#@ " << r.path << " | " << r.calls << " | " << r.wall * 1000 << " | " << r.cpu * 1000 << std::endl;
+  }
+  if (records.empty() || !counters::opened()) {
+    return;
+  }
+  out << "# Phase";
+  for (size_t c = 0; c < PERF_COUNTERS; ++c) {
+    out << " | " << counters::name(c);
+  }
+  out << std::endl;
+  for (auto &&r : records) {
+    out << "#! " << r.path;
+    for (size_t c = 0; c < PERF_COUNTERS; ++c) {
+      if (counters::available(c)) {
+        out << " | " << (unsigned long long) r.events[c];
+      } else {
+        out << " | -";
+      }
+    }
+    out << std::endl;
+  }
+}
+
+phase::phase(const char *name) : path_(opened.empty() ? name : *opened.back() + "/" + name), events_() {
+  opened.push_back(&path_);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = paths.find(path_);
+    if (it == paths.end()) {
+      it = paths.emplace(path_, records.size()).first;
+      records.push_back(record{path_, 0, 0, 0, {}});
+    }
+    record_ = it->second;
+  }
+  if (counters::opened()) {
+    counters::read(events_);
+  }
+  clock_ = std::this_thread::get_id() == main_thread ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID;
+  cpu_start_ = seconds(clock_);
+  start_ = std::chrono::steady_clock::now();
+}
+
+phase::~phase() {
+  auto wall = seconds(std::chrono::steady_clock::now() - start_);
+  auto cpu = seconds(clock_) - cpu_start_;
+  double events[PERF_COUNTERS];
+  if (counters::opened()) {
+    counters::read(events);
+  }
+  opened.pop_back();
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &r = records[record_];
+  ++r.calls;
+  r.wall += wall;
+  r.cpu += cpu;
+  if (counters::opened()) {
+    for (size_t c = 0; c < PERF_COUNTERS; ++c) {
+      r.events[c] += events[c] - events_[c];
+    }
+  }
 }
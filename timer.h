@@ -29,22 +29,65 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
+#include <chrono>
 #include <ctime>
+#include <ostream>
+#include <string>
+#include "counters.h"
 
+/**
+ * A stopwatch on the steady clock. Constructed with cpu set, it also
+ * measures the CPU time of the thread that starts and stops it.
+ */
 class timer {
 public:
+  static auto cputime() -> double;
   static auto microtime() -> double;
   static auto now() -> time_t;
   timer() = default;
+  explicit timer(bool cpu);
+  auto cpu() const -> double;
   auto reset() -> double;
   auto runtime() -> double;
   auto start() -> double;
   auto stop() -> double;
   auto total() -> double;
 private:
-  clock_t start_ = 0;
-  clock_t stop_ = 0;
-  clock_t total_ = 0;
+  typedef std::chrono::steady_clock clock;
+  clock::time_point start_;
+  clock::time_point stop_;
+  clock::duration total_ = clock::duration::zero();
+  bool stopped_ = false;
+  bool cpu_ = false;
+  double cpu_start_ = 0;
+  double cpu_total_ = 0;
+};
+
+/**
+ * A named phase, timed from construction to destruction in wall time and
+ * in CPU time: of the whole process for a phase of the main thread, so that
+ * the work of the threads it starts is counted, and of the thread itself
+ * for a phase of a worker, so that its siblings are not. A phase opened
+ * while another one is open on the same thread is nested under it, its
+ * path being "outer/inner"; phases opened by worker threads start their
+ * own paths. Times of a path add up over its calls, as do hardware
+ * counters once they are opened.
+ */
+class phase {
+public:
+  static void clear();
+  static void report(std::ostream &out);
+  explicit phase(const char *name);
+  phase(const phase &) = delete;
+  auto operator=(const phase &) -> phase & = delete;
+  ~phase();
+private:
+  std::string path_;
+  size_t record_;
+  std::chrono::steady_clock::time_point start_;
+  clockid_t clock_;
+  double cpu_start_;
+  double events_[PERF_COUNTERS];
 };
 
 #endif //TIMER_H_